@@ -0,0 +1,84 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+/**
+* This example shows how tasks which block are kept off the workers
+*   with Task::blocking (helpers/task_wrapper.hpp).
+*/
+
+#include <honeydew/honeydew.hpp>
+#include <honeydew/helpers/task_wrapper.hpp>
+#include <honeydew/detail/wait_flag.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace honeydew;
+
+int main(int argc, char* argv[])
+{
+    Honeydew* HONEYDEW = Honeydew::create(Honeydew::ROUND_ROBIN, 2, 1);
+
+    // Eight slow reads are marked as blocking so they run on the blocking pool. The two workers
+    //   keep running the quick tasks meanwhile, and each read's continuation comes back to a worker.
+    // Output: 100 quick tasks done before the reads, 8 reads continued on workers
+    {
+        std::atomic<int> reads_done(0);
+        std::atomic<int> quick_before_reads(0);
+        std::atomic<int> continued_on_worker(0);
+        std::atomic<int> remaining(8);
+        WaitFlag complete;
+
+        for(int i=0; i < 8; ++i)
+        {
+            HONEYDEW->post(Task([&] () {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                ++reads_done;
+            }).blocking().then([&] () {
+                if(HONEYDEW->current_worker() != Honeydew::no_worker)
+                    ++continued_on_worker;
+                if(--remaining == 0)
+                    complete.set();
+            }));
+        }
+
+        for(int i=0; i < 100; ++i)
+        {
+            HONEYDEW->post(Task([&] () {
+                if(reads_done == 0)
+                    ++quick_before_reads;
+            }));
+        }
+
+        complete.wait(HONEYDEW);
+        std::cout << quick_before_reads << " quick tasks done before the reads, "
+                  << continued_on_worker << " reads continued on workers" << std::endl;
+    }
+
+    // Fusing a pipeline keeps blocking stages apart from the others, so each still runs where it was meant to.
+    // Output: fused stages: parse on a worker, write on the blocking pool, notify on a worker
+    {
+        bool parsed_on_worker = false;
+        bool written_on_worker = true;
+        bool notified_on_worker = false;
+        WaitFlag complete;
+
+        HONEYDEW->post(Task([&] () {
+            parsed_on_worker = HONEYDEW->current_worker() != Honeydew::no_worker;
+        }).then([&] () {
+            written_on_worker = HONEYDEW->current_worker() != Honeydew::no_worker;
+        }).blocking().then([&] () {
+            notified_on_worker = HONEYDEW->current_worker() != Honeydew::no_worker;
+            complete.set();
+        }).fuse());
+
+        complete.wait(HONEYDEW);
+        std::cout << "fused stages: parse on " << (parsed_on_worker ? "a worker" : "the blocking pool")
+                  << ", write on " << (written_on_worker ? "a worker" : "the blocking pool")
+                  << ", notify on " << (notified_on_worker ? "a worker" : "the blocking pool") << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,72 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+/**
+* This example shows the typical usage of the Coroutine (helpers/coroutine.hpp) helper class.
+*   It requires a compiler with C++20 coroutine support.
+*/
+
+#include <honeydew/honeydew.hpp>
+#include <honeydew/helpers/coroutine.hpp>
+
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace honeydew;
+
+/**
+* A coroutine which returns a value to the coroutine awaiting it.
+*/
+Coroutine<int> add_on_worker(Honeydew* honeydew, int lhs, int rhs)
+{
+    // Move onto worker 1 before doing the work.
+    co_await schedule(honeydew, 1);
+    std::cout << std::this_thread::get_id() << " adding" << std::endl;
+    co_return lhs + rhs;
+}
+
+/**
+* The top level coroutine. Each step reads sequentially but no worker ever blocks.
+*/
+Coroutine<> run(Honeydew* honeydew, std::mutex& mut, std::condition_variable& cv, bool& complete)
+{
+    // Await another coroutine.
+    int sum = co_await add_on_worker(honeydew, 20, 2);
+
+    // Await the result of a posted function.
+    int product = co_await post_future(honeydew, [=] () { return sum * 2; });
+
+    // Await a Task structure.
+    co_await post_and_await(honeydew, Task([] () {
+        std::cout << std::this_thread::get_id() << " A" << std::endl;
+    }).also([] () {
+        std::cout << std::this_thread::get_id() << " B" << std::endl;
+    }), 2);
+
+    // Output: 44 (from worker 2)
+    std::cout << std::this_thread::get_id() << " " << product << std::endl;
+
+    std::unique_lock<std::mutex> lg(mut);
+    complete = true;
+    cv.notify_all();
+}
+
+int main(int argc, char* argv[])
+{
+    std::mutex mut;
+    std::condition_variable cv;
+    bool complete = false;
+
+    Honeydew* HONEYDEW = Honeydew::create(Honeydew::ROUND_ROBIN, 2, 1);
+
+    // Posting a coroutine starts it on a worker.
+    HONEYDEW->post(run(HONEYDEW, mut, cv, complete));
+
+    std::unique_lock<std::mutex> lg(mut);
+    while(!complete)
+        cv.wait(lg);
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+/**
+* This example shows the typical usage of Honeydew::post_after and Honeydew::post_at.
+*/
+
+#include <honeydew/honeydew.hpp>
+#include <honeydew/helpers/task_wrapper.hpp>
+#include <honeydew/detail/wait_flag.hpp>
+
+#include <iostream>
+#include <functional>
+
+using namespace honeydew;
+
+int main(int argc, char* argv[])
+{
+    Honeydew* HONEYDEW = Honeydew::create(Honeydew::ROUND_ROBIN, 2, 1);
+
+    // Delayed tasks run in the order of their deadlines, not the order they were posted.
+    // Output: A B C
+    {
+        WaitFlag complete;
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+        HONEYDEW->post_at(Task([] () { std::cout << "C" << std::endl; }, 1), now + std::chrono::milliseconds(300));
+        HONEYDEW->post_after(Task([] () { std::cout << "A" << std::endl; }, 1), std::chrono::milliseconds(100));
+        HONEYDEW->post_after(Task([] () { std::cout << "B" << std::endl; }, 1), std::chrono::milliseconds(200));
+        HONEYDEW->post_after(Task([&] () { complete.set(); }, 1), std::chrono::milliseconds(400));
+
+        complete.wait(HONEYDEW);
+    }
+
+    // A retry loop with exponential backoff. Posting a delayed task from a worker keeps
+    //   the timer on that worker, so no other thread is involved.
+    // Output: attempt 1 (10ms) ... attempt 5 (160ms) succeeded
+    {
+        WaitFlag complete;
+        std::function<void(int)> attempt;
+        attempt = [&] (int n) {
+            std::chrono::milliseconds backoff(10 << (n - 1));
+            std::cout << "attempt " << n << " (" << backoff.count() << "ms)" << std::endl;
+            if(n == 5)
+            {
+                std::cout << "succeeded" << std::endl;
+                complete.set();
+                return;
+            }
+            HONEYDEW->post_after(new task_t([&attempt, n] () { attempt(n + 1); }, 0, 0), backoff);
+        };
+        HONEYDEW->post(Task([&] () { attempt(1); }));
+
+        complete.wait(HONEYDEW);
+    }
+
+    return 0;
+}
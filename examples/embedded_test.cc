@@ -0,0 +1,101 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+/**
+* This example shows how an application thread, such as the main thread or an existing
+*   event loop, runs a worker of its own with run_one, poll and run_for.
+*/
+
+#include <honeydew/honeydew.hpp>
+#include <honeydew/helpers/task_wrapper.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace honeydew;
+
+int main(int argc, char* argv[])
+{
+    // Two workers with threads of their own, and one more the main thread runs.
+    std::vector<Honeydew::WorkerGroup> groups;
+    groups.push_back(Honeydew::WorkerGroup("pool", 2));
+    groups.push_back(Honeydew::WorkerGroup("main", 1, Honeydew::ROUND_ROBIN, 1, 0, Honeydew::BLOCK, true));
+    Honeydew* HONEYDEW = Honeydew::create(groups);
+    const size_t MAIN = 3;
+    const std::thread::id main_thread = std::this_thread::get_id();
+
+    // Work done on the pool hands its results back to the main thread, which runs them
+    //   one at a time between its own work.
+    // Output: 10 results handled on the main thread
+    {
+        int handled = 0;
+        int on_main_thread = 0;
+
+        for(int i=0; i < 10; ++i)
+        {
+            HONEYDEW->post(Task([] () {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }).then([&] () {
+                ++handled;
+                if(std::this_thread::get_id() == main_thread && HONEYDEW->current_worker_id() == MAIN)
+                    ++on_main_thread;
+            }, MAIN));
+        }
+
+        while(handled < 10)
+            HONEYDEW->run_one(MAIN);
+
+        std::cout << on_main_thread << " results handled on the main thread" << std::endl;
+    }
+
+    // poll never waits. run_for waits for tasks (and timers) until the time is up.
+    // Output: poll ran 0 tasks, run_for ran the task and the timer
+    {
+        size_t polled = HONEYDEW->poll(MAIN);
+
+        bool task_ran = false;
+        bool timer_fired = false;
+        HONEYDEW->post(Task([&] () { task_ran = true; }, MAIN));
+        HONEYDEW->post_after(Task([&] () { timer_fired = true; }, MAIN), std::chrono::milliseconds(20));
+        HONEYDEW->run_for(MAIN, std::chrono::milliseconds(100));
+
+        std::cout << "poll ran " << polled << " tasks, run_for ran " << (task_ran ? "the task" : "no task")
+                  << (timer_fired ? " and the timer" : " but not the timer") << std::endl;
+    }
+
+    // A Honeydew can also have no threads at all. Here another thread posts while the main
+    //   thread's loop polls the single worker in between its own work.
+    // Output: 1000 tasks ran on the main thread
+    {
+        std::vector<Honeydew::WorkerGroup> loop_only;
+        loop_only.push_back(Honeydew::WorkerGroup("loop", 1, Honeydew::THREAD_PER_CORE, 16, 0, Honeydew::BLOCK, true));
+        Honeydew* LOOP = Honeydew::create(loop_only);
+
+        std::atomic<int> ran(0);
+        int on_main_thread = 0;
+        std::thread producer([&] () {
+            for(int i=0; i < 1000; ++i)
+            {
+                LOOP->post(Task([&] () {
+                    ++ran;
+                    if(std::this_thread::get_id() == main_thread)
+                        ++on_main_thread;
+                }));
+            }
+        });
+
+        while(ran < 1000)
+        {
+            LOOP->poll(1);
+            std::this_thread::yield();
+        }
+        producer.join();
+
+        std::cout << on_main_thread << " tasks ran on the main thread" << std::endl;
+    }
+
+    return 0;
+}
@@ -7,9 +7,12 @@
 */
 
 #include <honeydew/helpers/event_processor.hpp>
+#include <honeydew/detail/wait_flag.hpp>
 
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
 
 using namespace honeydew;
 
@@ -40,6 +43,17 @@ struct MockEventType
     std::string name;
 };
 
+/**
+ * Small enums (or integers) can be used with a dense EventProcessor, which indexes
+ *   a flat array with the key instead of hashing it.
+ */
+enum MockEventKey
+{
+    KEY_PING,
+    KEY_PONG,
+    NUM_KEYS
+};
+
 int main(int argc, char* argv[])
 {
     // These variables are used to control the flow of the main thread
@@ -85,5 +99,110 @@ int main(int argc, char* argv[])
     while(!complete)
         cv.wait(lg);
 
+    // A dense EventProcessor is created by giving the number of keys as well.
+    EventProcessor<MockEventKey, NUM_KEYS> dense_system(HONEYDEW);
+    complete = false;
+
+    // The handlers are bound the same way.
+    dense_system.bind_castable<const char>(KEY_PONG,
+    [&](const char* name) {
+        printf("%s\n", name);
+        {
+            std::unique_lock<std::mutex> lg(mut);
+            complete = true;
+        }
+        cv.notify_all();
+    });
+
+    dense_system.post_event(KEY_PONG, val);
+
+    while(!complete)
+        cv.wait(lg);
+
+    // Any number of subscribers can receive the broadcasts of a key. They all share
+    //   a single immutable copy of the payload.
+    // Output: "audit: DOGGY" and "cache: DOGGY" in any order.
+    int remaining = 2;
+    auto subscriber = [&](const char* name) {
+        return [&, name](const std::string& payload) {
+            printf("%s: %s\n", name, payload.c_str());
+            {
+                std::unique_lock<std::mutex> lg(mut);
+                --remaining;
+            }
+            cv.notify_all();
+        };
+    };
+    dense_system.subscribe<std::string>(KEY_PING, subscriber("audit"), 1);
+    dense_system.subscribe<std::string>(KEY_PING, subscriber("cache"), 2);
+
+    dense_system.broadcast(KEY_PING, std::string(val));
+
+    while(remaining > 0)
+        cv.wait(lg);
+
+    // Rebinding or unbinding a key doesn't change the events already posted: they run the
+    //   handler they were posted with. Worker 1 is held up so the events queue behind it.
+    // Output: old old old new new
+    {
+        WaitFlag gate;
+        WaitFlag drained;
+        std::string ran;
+        HONEYDEW->post(Task([&] () { gate.wait(nullptr); }, 1));
+
+        dense_system.bind_castable<const char>(KEY_PONG, [&](const char*) { ran += "old "; }, 1);
+        for(int i=0; i < 3; ++i)
+            dense_system.post_event(KEY_PONG);
+
+        dense_system.bind_castable<const char>(KEY_PONG, [&](const char*) { ran += "new "; }, 1);
+        for(int i=0; i < 2; ++i)
+            dense_system.post_event(KEY_PONG);
+
+        // Events posted after the unbind are ignored.
+        dense_system.unbind(KEY_PONG);
+        for(int i=0; i < 2; ++i)
+            dense_system.post_event(KEY_PONG);
+
+        gate.set();
+        HONEYDEW->post(Task([&] () { drained.set(); }, 1));
+        drained.wait(HONEYDEW);
+        printf("%s\n", ran.c_str());
+    }
+
+    // A batch of events is posted with one task per worker and priority rather than one per
+    //   event. Keys may be mixed freely: events of one key still run in batch order, and
+    //   events of unbound keys are ignored.
+    // Output: 1: abc 2: xy 3: pq
+    {
+        std::string received[4];
+        std::atomic<int> handled(0);
+        WaitFlag complete;
+        auto append_to = [&](int key) {
+            return [&, key](const char* letter) {
+                received[key] += *letter;
+                if(++handled == 7)
+                    complete.set();
+            };
+        };
+        event_system.bind_castable<const char>(1, append_to(1));
+        event_system.bind_castable<const char>(2, append_to(2));
+        event_system.bind_castable<const char>(3, append_to(3), 2);
+
+        char letters[] = "abcxypqz";
+        std::vector<std::pair<int, void*>> batch;
+        batch.push_back(std::make_pair(1, &letters[0]));
+        batch.push_back(std::make_pair(2, &letters[3]));
+        batch.push_back(std::make_pair(3, &letters[5]));
+        batch.push_back(std::make_pair(1, &letters[1]));
+        batch.push_back(std::make_pair(99, &letters[7]));
+        batch.push_back(std::make_pair(2, &letters[4]));
+        batch.push_back(std::make_pair(1, &letters[2]));
+        batch.push_back(std::make_pair(3, &letters[6]));
+        event_system.post_events(batch.begin(), batch.end());
+
+        complete.wait(HONEYDEW);
+        printf("1: %s 2: %s 3: %s\n", received[1].c_str(), received[2].c_str(), received[3].c_str());
+    }
+
     return 0;
 }
@@ -0,0 +1,134 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+/**
+* This example shows how a long task can give way to other tasks part way through
+*   by running as a fiber (helpers/fiber.hpp).
+*/
+
+#include <honeydew/honeydew.hpp>
+#include <honeydew/helpers/fiber.hpp>
+#include <honeydew/helpers/future.hpp>
+#include <honeydew/detail/wait_flag.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace honeydew;
+
+int main(int argc, char* argv[])
+{
+    Honeydew* HONEYDEW = Honeydew::create(Honeydew::ROUND_ROBIN_WITH_PRIORITY, 2, 1);
+
+    // A long computation on worker 1 posts an urgent task after each chunk and yields, so the
+    //   urgent task runs before the next chunk instead of after the whole computation.
+    // Output: chunk 0 urgent 0 chunk 1 urgent 1 chunk 2 urgent 2 chunk 3 urgent 3 done
+    {
+        std::ostringstream order;
+        WaitFlag complete;
+
+        HONEYDEW->post(FiberTask(HONEYDEW, [&] () {
+            for(int i=0; i < 4; ++i)
+            {
+                order << "chunk " << i << " ";
+                HONEYDEW->post(Task([&order, i] () { order << "urgent " << i << " "; }, 1, 0));
+                honeydew::yield();
+            }
+        }, 1, 10).then(Task([&] () {
+            order << "done";
+            complete.set();
+        }, 1, 10)));
+
+        complete.wait(HONEYDEW);
+        std::cout << order.str() << std::endl;
+    }
+
+    // A fiber waiting on a future doesn't hold up its worker: worker 1 runs the tasks posted
+    //   while the fiber is suspended, and the fiber resumes on worker 1 once the value arrives.
+    // Output: 10 tasks ran while waiting, value 42 on worker 1
+    {
+        std::atomic<int> ran_while_waiting(0);
+        std::atomic<bool> waiting(false);
+        size_t resumed_on = 0;
+        int value = 0;
+        WaitFlag complete;
+
+        HONEYDEW->post(FiberTask(HONEYDEW, [&] () {
+            waiting = true;
+            for(int i=0; i < 10; ++i)
+            {
+                HONEYDEW->post(Task([&] () {
+                    if(waiting)
+                        ++ran_while_waiting;
+                }, 1));
+            }
+            value = await(post_future(HONEYDEW, [] () {
+                honeydew::sleep_for(std::chrono::milliseconds(50));
+                return 42;
+            }, 2));
+            waiting = false;
+            resumed_on = HONEYDEW->current_worker_id();
+            complete.set();
+        }, 1));
+
+        complete.wait(HONEYDEW);
+        std::cout << ran_while_waiting << " tasks ran while waiting, value " << value
+                  << " on worker " << resumed_on << std::endl;
+    }
+
+    // Many fibers sleeping at once on a single worker: they overlap instead of taking turns.
+    // Output: 100 fibers slept 100ms each in less than 1 second
+    {
+        std::atomic<int> remaining(100);
+        WaitFlag complete;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        for(int i=0; i < 100; ++i)
+        {
+            HONEYDEW->post(FiberTask(HONEYDEW, [&] () {
+                honeydew::sleep_for(std::chrono::milliseconds(100));
+                if(--remaining == 0)
+                    complete.set();
+            }, 2));
+        }
+
+        complete.wait(HONEYDEW);
+        bool overlapped = std::chrono::steady_clock::now() - start < std::chrono::seconds(1);
+        std::cout << "100 fibers slept 100ms each in " << (overlapped ? "less" : "more")
+                  << " than 1 second" << std::endl;
+    }
+
+    // An exception thrown after a yield reaches the exception handler and the continuation still runs.
+    // Output: caught fiber failed, continuation ran
+    {
+        std::string caught;
+        WaitFlag handled;
+        WaitFlag continued;
+
+        HONEYDEW->set_exception_handler([&] (std::exception_ptr e) {
+            try
+            {
+                std::rethrow_exception(e);
+            }
+            catch(std::exception& ex)
+            {
+                caught = ex.what();
+            }
+            handled.set();
+        });
+
+        HONEYDEW->post(FiberTask(HONEYDEW, [] () {
+            honeydew::yield();
+            throw std::runtime_error("fiber failed");
+        }).then(Task([&] () { continued.set(); })));
+
+        handled.wait(HONEYDEW);
+        continued.wait(HONEYDEW);
+        std::cout << "caught " << caught << ", continuation ran" << std::endl;
+    }
+
+    return 0;
+}
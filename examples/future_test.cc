@@ -0,0 +1,70 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+/**
+* This example shows the typical usage of the Future and Promise
+*   (helpers/future.hpp) helper classes.
+*/
+
+#include <honeydew/honeydew.hpp>
+#include <honeydew/helpers/future.hpp>
+
+#include <iostream>
+#include <string>
+
+using namespace honeydew;
+
+int main(int argc, char* argv[])
+{
+    Honeydew* HONEYDEW = Honeydew::create(Honeydew::ROUND_ROBIN, 2, 1);
+
+    // Post a task and receive its result through a future.
+    // Output: 42
+    Future<int> answer = post_future(HONEYDEW, [] () { return 6 * 7; });
+    printf("%d\n", answer.get());
+
+    // Continuations are posted straight into the Honeydew once the value is ready.
+    //   The value is passed along instead of being stored in a heap allocated object.
+    //   The result type is deduced from the action unless it is given, as in the second then.
+    // Output: 42 is the answer
+    Future<std::string> sentence = answer.then([] (int val) {
+        return std::to_string(val) + " is the answer";
+    }).then<std::string>([] (std::string val) {
+        return val;
+    }, 2);
+    printf("%s\n", sentence.get().c_str());
+
+    // Exceptions thrown by the task are rethrown by get().
+    // Output: Caught: Oops
+    Future<void> failing = post_future(HONEYDEW, [] () { throw std::runtime_error("Oops"); });
+    try
+    {
+        failing.get();
+    }
+    catch(std::runtime_error& e)
+    {
+        printf("Caught: %s\n", e.what());
+    }
+
+    // Promises allow values which are not the result of a single task to be awaited.
+    // Output: 7
+    Promise<int> promise(HONEYDEW);
+    Future<void> printed = promise.get_future().then([] (int val) {
+        printf("%d\n", val);
+    });
+    promise.set_value(7);
+    printed.wait();
+
+    // A promise is satisfied only once.
+    // Output: Caught: Promise already satisfied
+    try
+    {
+        promise.set_value(8);
+    }
+    catch(std::logic_error& e)
+    {
+        printf("Caught: %s\n", e.what());
+    }
+
+    return 0;
+}
@@ -0,0 +1,67 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+/**
+* This example shows how a Honeydew can be split into worker groups
+*   so that slow I/O work never delays latency sensitive compute work.
+*/
+
+#include <honeydew/honeydew.hpp>
+#include <honeydew/helpers/task_wrapper.hpp>
+#include <honeydew/detail/wait_flag.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace honeydew;
+
+int main(int argc, char* argv[])
+{
+    // Workers 1-2 form the "io" group and workers 3-6 the "compute" group, each with its own policy.
+    std::vector<Honeydew::WorkerGroup> groups;
+    groups.push_back(Honeydew::WorkerGroup("io", 2, Honeydew::ROUND_ROBIN));
+    groups.push_back(Honeydew::WorkerGroup("compute", 4, Honeydew::LEAST_BUSY_WITH_PRIORITY));
+    Honeydew* HONEYDEW = Honeydew::create(groups);
+
+    size_t io = HONEYDEW->group("io");
+    size_t compute = HONEYDEW->group("compute");
+
+    // The slow reads occupy the io workers only. Each read continues on the compute group,
+    //   where the quick tasks posted meanwhile didn't have to wait behind the reads.
+    // Output: 100 quick tasks ran on compute workers while 8 reads ran on io workers
+    {
+        std::atomic<int> quick_on_compute(0);
+        std::atomic<int> reads_on_io(0);
+        std::atomic<int> remaining(8);
+        WaitFlag complete;
+
+        for(int i=0; i < 8; ++i)
+        {
+            HONEYDEW->post(Task([&] () {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                if(HONEYDEW->current_worker() < 2)
+                    ++reads_on_io;
+            }, io).then([&] () {
+                if(--remaining == 0)
+                    complete.set();
+            }, compute));
+        }
+
+        for(int i=0; i < 100; ++i)
+        {
+            HONEYDEW->post(Task([&] () {
+                if(HONEYDEW->current_worker() >= 2)
+                    ++quick_on_compute;
+            }, compute));
+        }
+
+        complete.wait(HONEYDEW);
+        std::cout << quick_on_compute << " quick tasks ran on compute workers while "
+                  << reads_on_io << " reads ran on io workers" << std::endl;
+    }
+
+    return 0;
+}
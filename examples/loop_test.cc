@@ -0,0 +1,58 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+/**
+* This example shows the typical usage of the LoopTask and SwitchTask
+*   (helpers/loop_task.hpp) helper classes.
+*/
+
+#include <honeydew/honeydew.hpp>
+#include <honeydew/helpers/loop_task.hpp>
+#include <honeydew/detail/wait_flag.hpp>
+
+#include <iostream>
+
+using namespace honeydew;
+
+int main(int argc, char* argv[])
+{
+    Honeydew* HONEYDEW = Honeydew::create(Honeydew::ROUND_ROBIN, 4, 1);
+
+    // The loop's tasks are built once and reposted on every iteration. Each iteration
+    //   runs the switch, whose untaken cases are kept for the next iteration.
+    //   The stages of the loop run one after the other, so the plain ints are safe.
+    // Output: fizz 27 buzz 13 fizzbuzz 7 other 53
+    {
+        int i = 0;
+        int fizz = 0, buzz = 0, fizzbuzz = 0, other = 0;
+        WaitFlag complete;
+
+        HONEYDEW->post(LoopTask([&] () { return i < 100; })
+            .then(std::move(SwitchTask([&] () { return (i % 3 == 0 ? 1 : 0) + (i % 5 == 0 ? 2 : 0); })
+                .on(1).then([&] () { ++fizz; })
+                .on(2).then([&] () { ++buzz; })
+                .on(3).then([&] () { ++fizzbuzz; })
+                .otherwise().then([&] () { ++other; })))
+            .then([&] () { ++i; })
+            .after(Task([&] () { complete.set(); })));
+
+        complete.wait(HONEYDEW);
+        std::cout << "fizz " << fizz << " buzz " << buzz << " fizzbuzz " << fizzbuzz << " other " << other << std::endl;
+    }
+
+    // A REPEAT_UNTIL loop runs its body before checking the condition, like a retry loop.
+    // Output: succeeded after 5 attempts
+    {
+        int attempts = 0;
+        WaitFlag complete;
+
+        HONEYDEW->post(LoopTask([&] () { return attempts == 5; }, LoopTask::REPEAT_UNTIL)
+            .then([&] () { ++attempts; })
+            .after(Task([&] () { complete.set(); })));
+
+        complete.wait(HONEYDEW);
+        std::cout << "succeeded after " << attempts << " attempts" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,225 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+/**
+* This example shows what each overflow policy does when tasks are posted to a full queue.
+*   Every Honeydew here has a single worker whose queue holds 2 tasks, and the worker is held
+*   up while the queue is filled.
+*/
+
+#include <honeydew/honeydew.hpp>
+#include <honeydew/helpers/task_wrapper.hpp>
+#include <honeydew/helpers/strand.hpp>
+#include <honeydew/helpers/timer.hpp>
+#include <honeydew/detail/wait_flag.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace honeydew;
+
+/**
+* Records the labels of the tasks which ran, and signals once the expected number did.
+*/
+struct Recorder
+{
+    Recorder(int expected)
+        : count(0)
+        , expected(expected)
+    {
+    }
+
+    std::function<void()> record(const std::string& label)
+    {
+        return [this, label] () {
+            ran += ran.empty() ? label : " " + label;
+            if(++count == expected)
+                done.set();
+        };
+    }
+
+    // Only touched by the single worker until done is set.
+    std::string ran;
+    std::atomic<int> count;
+    int expected;
+    WaitFlag done;
+};
+
+/**
+* Holds up the worker until the gate is set, so posted tasks stay queued.
+*/
+void hold(Honeydew* honeydew, WaitFlag& gate)
+{
+    WaitFlag started;
+    honeydew->post(Task([&] () {
+        started.set();
+        gate.wait(nullptr);
+    }, 1));
+    started.wait(nullptr);
+}
+
+int main(int argc, char* argv[])
+{
+    // BLOCK: try_post rejects a task which doesn't fit and post waits for room.
+    // Output: BLOCK: try_post rejected c, ran a b d
+    {
+        Honeydew* HONEYDEW = Honeydew::create(Honeydew::ROUND_ROBIN, 1, 1, 2, Honeydew::BLOCK);
+        Recorder recorder(3);
+        WaitFlag gate;
+        hold(HONEYDEW, gate);
+
+        HONEYDEW->post(Task(recorder.record("a"), 1));
+        HONEYDEW->post(Task(recorder.record("b"), 1));
+        bool posted = HONEYDEW->try_post(Task(recorder.record("c"), 1));
+        std::thread poster([&] () { HONEYDEW->post(Task(recorder.record("d"), 1)); });
+
+        gate.set();
+        poster.join();
+        recorder.done.wait(nullptr);
+        std::cout << "BLOCK: try_post " << (posted ? "posted" : "rejected") << " c, ran " << recorder.ran << std::endl;
+    }
+
+    // FAIL: post throws once a task is rejected. The rest of a fan out still runs and, as the
+    //   rejected branch counts as done, the joined continuation fires.
+    // Output: FAIL: post threw, try_post rejected c, ran a x z
+    {
+        Honeydew* HONEYDEW = Honeydew::create(Honeydew::ROUND_ROBIN, 1, 1, 2, Honeydew::FAIL);
+        Recorder recorder(3);
+        WaitFlag gate;
+        hold(HONEYDEW, gate);
+
+        HONEYDEW->post(Task(recorder.record("a"), 1));
+        bool threw = false;
+        try
+        {
+            HONEYDEW->post(Task(recorder.record("x"), 1).also(recorder.record("y"), 1).then(recorder.record("z"), 1));
+        }
+        catch(std::overflow_error&)
+        {
+            threw = true;
+        }
+        bool posted = HONEYDEW->try_post(Task(recorder.record("c"), 1));
+
+        gate.set();
+        recorder.done.wait(nullptr);
+        std::cout << "FAIL: post " << (threw ? "threw" : "didn't throw") << ", try_post " << (posted ? "posted" : "rejected")
+                  << " c, ran " << recorder.ran << std::endl;
+    }
+
+    // A THREAD_PER_CORE Honeydew rejects tasks from other threads once a worker's injection
+    //   ring is full, and the fan out joins just the same.
+    // Output: THREAD_PER_CORE FAIL: post threw, ran a x z
+    {
+        Honeydew* HONEYDEW = Honeydew::create(Honeydew::THREAD_PER_CORE, 1, 1, 2, Honeydew::FAIL);
+        Recorder recorder(3);
+        WaitFlag gate;
+        hold(HONEYDEW, gate);
+
+        HONEYDEW->post(Task(recorder.record("a"), 1));
+        bool threw = false;
+        try
+        {
+            HONEYDEW->post(Task(recorder.record("x"), 1).also(recorder.record("y"), 1).then(recorder.record("z"), 1));
+        }
+        catch(std::overflow_error&)
+        {
+            threw = true;
+        }
+
+        gate.set();
+        recorder.done.wait(nullptr);
+        std::cout << "THREAD_PER_CORE FAIL: post " << (threw ? "threw" : "didn't throw") << ", ran " << recorder.ran << std::endl;
+    }
+
+    // DROP_OLDEST: the oldest queued task makes room. Dropping a branch of a fan out still
+    //   lets the joined continuation fire after the other branch.
+    // Output: DROP_OLDEST: ran y e z
+    {
+        Honeydew* HONEYDEW = Honeydew::create(Honeydew::ROUND_ROBIN, 1, 1, 2, Honeydew::DROP_OLDEST);
+        Recorder recorder(3);
+        WaitFlag gate;
+        hold(HONEYDEW, gate);
+
+        HONEYDEW->post(Task(recorder.record("x"), 1).also(recorder.record("y"), 1).then(recorder.record("z"), 1));
+        HONEYDEW->post(Task(recorder.record("e"), 1));
+
+        gate.set();
+        recorder.done.wait(nullptr);
+        std::cout << "DROP_OLDEST: ran " << recorder.ran << std::endl;
+    }
+
+    // The tasks keeping timers, strands and other helpers going are internal and are never
+    //   dropped. Here only internal tasks are queued, so the task posted last has to go instead.
+    // Output: internal tasks kept: ran strand strand strand timer
+    {
+        Honeydew* HONEYDEW = Honeydew::create(Honeydew::ROUND_ROBIN, 1, 1, 2, Honeydew::DROP_OLDEST);
+        Recorder recorder(4);
+        WaitFlag gate;
+        hold(HONEYDEW, gate);
+
+        HONEYDEW->post_after(Task(recorder.record("timer"), 1), std::chrono::milliseconds(20));
+        Strand strand(HONEYDEW, 1);
+        for(int i=0; i < 3; ++i)
+            strand.post(recorder.record("strand"));
+        HONEYDEW->post(Task(recorder.record("dropped"), 1));
+
+        gate.set();
+        recorder.done.wait(nullptr);
+        std::cout << "internal tasks kept: ran " << recorder.ran << std::endl;
+    }
+
+    // A Timer's firing tasks are internal too, so a timer expiring while the queue is full
+    //   neither throws on the timer's thread nor is lost.
+    // Output: FAIL with a Timer: ran a b tick
+    {
+        Honeydew* HONEYDEW = Honeydew::create(Honeydew::ROUND_ROBIN, 1, 1, 2, Honeydew::FAIL);
+        Recorder recorder(3);
+        WaitFlag gate;
+        hold(HONEYDEW, gate);
+
+        HONEYDEW->post(Task(recorder.record("a"), 1));
+        HONEYDEW->post(Task(recorder.record("b"), 1));
+        Timer<10> timer(HONEYDEW);
+        std::function<void()> tick = recorder.record("tick");
+        timer.schedule([&] () {
+            tick();
+            return false;
+        }, 1, 1);
+
+        // Let the timer expire while the queue is still full.
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        gate.set();
+        recorder.done.wait(nullptr);
+        timer.shutdown();
+        std::cout << "FAIL with a Timer: ran " << recorder.ran << std::endl;
+    }
+
+    // DROP_LOWEST_PRIORITY: the task with the largest priority value makes room, which may be
+    //   the task being posted. The same holds for FIFO queues and priority heaps.
+    // Output: DROP_LOWEST_PRIORITY (queue): ran b d
+    //         DROP_LOWEST_PRIORITY (heap): ran b d
+    Honeydew::HoneydewType types[] = {Honeydew::ROUND_ROBIN, Honeydew::ROUND_ROBIN_WITH_PRIORITY};
+    for(size_t t=0; t < 2; ++t)
+    {
+        Honeydew* HONEYDEW = Honeydew::create(types[t], 1, 1, 2, Honeydew::DROP_LOWEST_PRIORITY);
+        Recorder recorder(2);
+        WaitFlag gate;
+        hold(HONEYDEW, gate);
+
+        HONEYDEW->post(Task(recorder.record("a"), 1, 5));
+        HONEYDEW->post(Task(recorder.record("b"), 1, 1));
+        HONEYDEW->post(Task(recorder.record("c"), 1, 9));
+        HONEYDEW->post(Task(recorder.record("d"), 1, 3));
+
+        gate.set();
+        recorder.done.wait(nullptr);
+        std::cout << "DROP_LOWEST_PRIORITY (" << (t == 0 ? "queue" : "heap") << "): ran " << recorder.ran << std::endl;
+    }
+
+    return 0;
+}
@@ -11,11 +11,15 @@
 
 #include <honeydew/honeydew.hpp>
 #include <honeydew/helpers/pipeline.hpp>
+#include <honeydew/helpers/task_wrapper.hpp>
 
 #include <iostream>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <memory>
+#include <vector>
+#include <stdexcept>
 
 using namespace honeydew;
 
@@ -89,6 +93,112 @@ int main(int argc, char* argv[])
         cv.notify_all();
     })); 
 
+    while(!complete)
+        cv.wait(lg);
+
+    complete = false;
+
+    // Stage results are moved from one stage into the next, so large or move-only
+    //   values such as a std::unique_ptr are passed along without being copied.
+    // Output:
+    //        1048576 bytes
+    HONEYDEW->post(Pipeline::start<std::unique_ptr<std::vector<char>>>([] () {
+        return std::unique_ptr<std::vector<char>>(new std::vector<char>(1 << 20));
+    }).then<size_t>([] (std::unique_ptr<std::vector<char>> buffer) {
+        return buffer->size();
+    }).then([&] (size_t size) {
+        printf("%lu bytes\n", size);
+
+        // Notify main thread to continue
+        {
+            std::unique_lock<std::mutex> lg(return_mut);
+            complete = true;
+        }
+        cv.notify_all();
+    }));
+
+    while(!complete)
+        cv.wait(lg);
+
+    complete = false;
+
+    // Scattered tasks run concurrently on the fork's value and each writes its result into
+    //   its own slot, so no locking is needed. reduce() folds the results in the order the
+    //   tasks were added (gather() would receive them as a std::vector).
+    // Output:
+    //        sum of squares 30
+    HONEYDEW->post(Pipeline::start_forked<int>([] () {
+        return 1;
+    }).scatter<int>([] (int base) { return base * base; })
+      .scatter([] (int base) { return (base + 1) * (base + 1); })
+      .scatter([] (int base) { return (base + 2) * (base + 2); })
+      .scatter([] (int base) { return (base + 3) * (base + 3); })
+      .reduce([] (int sum, int square) {
+        return sum + square;
+    }).then([&] (int sum) {
+        printf("sum of squares %d\n", sum);
+
+        // Notify main thread to continue
+        {
+            std::unique_lock<std::mutex> lg(return_mut);
+            complete = true;
+        }
+        cv.notify_all();
+    }));
+
+    while(!complete)
+        cv.wait(lg);
+
+    complete = false;
+
+    // Closing a pipeline fuses consecutive stages on the same worker into one task, so they run
+    //   back to back: the task the first stage posts to worker 1 waits until all three are done.
+    //   The stages still run in order, and every exception of a fused task still reaches the
+    //   exception handler.
+    // Output:
+    //        stage a
+    //        stage b
+    //        stage c
+    //        queued behind the stages
+    //        handled first
+    //        handled second
+    int remaining = 3;
+    auto finish_one = [&] () {
+        std::unique_lock<std::mutex> lg(return_mut);
+        if(--remaining == 0)
+        {
+            complete = true;
+            cv.notify_all();
+        }
+    };
+
+    HONEYDEW->set_exception_handler([&] (std::exception_ptr e) {
+        try
+        {
+            std::rethrow_exception(e);
+        }
+        catch(std::runtime_error& error)
+        {
+            printf("handled %s\n", error.what());
+        }
+        finish_one();
+    }, 1);
+
+    HONEYDEW->post(Pipeline::start<int>([&] () {
+        printf("stage a\n");
+        HONEYDEW->post(Task([&] () {
+            printf("queued behind the stages\n");
+            finish_one();
+        }, 1));
+        return 1;
+    }, 1).then([] (int) {
+        printf("stage b\n");
+        throw std::runtime_error("first");
+    }, 1).then([] () {
+        printf("stage c\n");
+        throw std::runtime_error("second");
+    }, 1).close());
+
     while(!complete)
         cv.wait(lg);
 }
@@ -9,12 +9,12 @@
 */
 
 #include <honeydew/honeydew.hpp>
-#include <honeydew/helpers/task_wrapper.hpp>
-#include <honeydew/helpers/post_and_wait.hpp>
+#include <honeydew/helpers/parallel.hpp>
 
 #include <iostream>
 #include <thread>
 #include <atomic>
+#include <stdexcept>
 
 using namespace honeydew;
 
@@ -30,6 +30,8 @@ int main(int argc, char* argv[])
     std::getline(std::cin, buf);
 
     size_t sieve_size = std::stoi(buf);
+    if(sieve_size < 2)
+        sieve_size = 2;
     std::atomic<size_t>* sieve = new std::atomic<size_t>[sieve_size-2];
 
     printf("Constructing sieve of elements up to %lu...\n", sieve_size);
@@ -43,33 +45,66 @@ int main(int argc, char* argv[])
     // Initialize the Honeydew
     Honeydew* HONEYDEW = Honeydew::create(Honeydew::ROUND_ROBIN, std::thread::hardware_concurrency(), 0);
 
-    // Schedule the tasks
-    Task task([] () {});
+    // Cross out the multiples of every number. parallel_for splits the range into chunks
+    //   of at most 64 numbers which are spread across the workers. Below 6 the range is
+    //   empty or inverted (e.g. [2, 1) for 3) and the loop completes without calling the body.
     size_t maximum_in_range = sieve_size/2;
-    for(size_t i=0; i < maximum_in_range-2; ++i)
-    {
-        task.also([&, i] () {
-            size_t n = i+2;
-            for(size_t j=n-2 + n; j < sieve_size; j += n)
+    parallel_for(HONEYDEW, Range<size_t>(2, maximum_in_range), 64, [&] (size_t begin, size_t end) {
+        for(size_t n=begin; n < end; ++n)
+        {
+            for(size_t j=n-2 + n; j < sieve_size-2; j += n)
             {
                 sieve[j].store(0);
             }
-        });
-    }
+        }
+    });
 
-    // Schedule the last printing task
-    task.then([&] () {
-        for(size_t i=0; i < sieve_size-2; ++i)
+    // Count the remaining primes concurrently.
+    size_t prime_count = parallel_reduce(HONEYDEW, Range<size_t>(0, sieve_size-2), 1024, (size_t)0,
+    [&] (size_t begin, size_t end) {
+        size_t count = 0;
+        for(size_t i=begin; i < end; ++i)
         {
-            size_t val = sieve[i].load();
-            if(val != 0)
-                printf("%lu ", val);
+            if(sieve[i].load() != 0)
+                ++count;
         }
-        printf("\n");
+        return count;
+    }, [] (size_t lhs, size_t rhs) {
+        return lhs + rhs;
     });
 
-    // Post to the Honeydew.
-    post_and_wait(HONEYDEW, task);
+    // Print the results
+    for(size_t i=0; i < sieve_size-2; ++i)
+    {
+        size_t val = sieve[i].load();
+        if(val != 0)
+            printf("%lu ", val);
+    }
+    printf("\n%lu primes found.\n", prime_count);
+
+    // An inverted range is empty, so the body never runs.
+    // Output: inverted range: body ran 0 times
+    std::atomic<int> calls(0);
+    parallel_for(HONEYDEW, Range<size_t>(10, 5), 1, [&] (size_t begin, size_t end) { ++calls; });
+    printf("inverted range: body ran %d times\n", calls.load());
+
+    // A reduction whose body throws doesn't return a result missing that chunk: the
+    //   exception is rethrown instead.
+    // Output: reduction failed: chunk failed
+    try
+    {
+        parallel_reduce(HONEYDEW, Range<size_t>(0, 100), 10, (size_t)0, [] (size_t begin, size_t end) {
+            if(begin == 50)
+                throw std::runtime_error("chunk failed");
+            return end - begin;
+        }, [] (size_t lhs, size_t rhs) {
+            return lhs + rhs;
+        });
+    }
+    catch(std::runtime_error& e)
+    {
+        printf("reduction failed: %s\n", e.what());
+    }
 
     return 0;
 }
@@ -0,0 +1,205 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+/**
+* This example shows how file descriptor readiness becomes Honeydew tasks
+*   with a Reactor (helpers/reactor.hpp).
+*/
+
+#include <honeydew/honeydew.hpp>
+#include <honeydew/helpers/reactor.hpp>
+#include <honeydew/helpers/task_wrapper.hpp>
+#include <honeydew/detail/wait_flag.hpp>
+
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+using namespace honeydew;
+
+int main(int argc, char* argv[])
+{
+    Honeydew* HONEYDEW = Honeydew::create(Honeydew::ROUND_ROBIN, 2, 1);
+
+    // Eight pipes are split between the two workers, as connections would be. Every message
+    //   is read by a handler on the worker owning its pipe.
+    // Output: 800 messages read, each on its pipe's worker
+    {
+        Reactor reactor(HONEYDEW);
+        reactor.start();
+
+        int pipes[8][2];
+        std::atomic<int> messages(0);
+        std::atomic<int> misplaced(0);
+        WaitFlag complete;
+
+        for(size_t i=0; i < 8; ++i)
+        {
+            if(pipe(pipes[i]) != 0)
+                return 1;
+
+            int fd = pipes[i][0];
+            size_t worker = i % 2 + 1;
+            reactor.add(fd, EPOLLIN, [&, fd, worker] (uint32_t events) {
+                if(HONEYDEW->current_worker_id() != worker)
+                    ++misplaced;
+
+                char buffer[64];
+                ssize_t bytes = read(fd, buffer, sizeof(buffer));
+                for(ssize_t b=0; b < bytes; ++b)
+                {
+                    if(++messages == 800)
+                        complete.set();
+                }
+            }, worker);
+        }
+
+        for(int round=0; round < 100; ++round)
+        {
+            for(size_t i=0; i < 8; ++i)
+            {
+                char message = 'x';
+                if(write(pipes[i][1], &message, 1) != 1)
+                    return 1;
+            }
+        }
+
+        complete.wait(HONEYDEW);
+        reactor.stop();
+        for(size_t i=0; i < 8; ++i)
+        {
+            reactor.remove(pipes[i][0]);
+            close(pipes[i][0]);
+            close(pipes[i][1]);
+        }
+
+        std::cout << messages << " messages read, " << (misplaced == 0 ? "each on its pipe's worker" : "some on the wrong worker") << std::endl;
+    }
+
+    // A timerfd ticks until its handler has seen five expirations and removes it.
+    //   The eventfd's writes are coalesced by the kernel, so its handler sees the sum.
+    // Output: timer ticked at least 5 times, eventfd counted 6
+    {
+        Reactor reactor(HONEYDEW);
+        reactor.start();
+
+        int timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+        itimerspec period = {{0, 10 * 1000 * 1000}, {0, 10 * 1000 * 1000}};
+        timerfd_settime(timer, 0, &period, nullptr);
+
+        uint64_t ticks = 0;
+        WaitFlag ticked;
+        reactor.add(timer, EPOLLIN, [&] (uint32_t events) {
+            uint64_t expirations = 0;
+            if(read(timer, &expirations, sizeof(expirations)) == sizeof(expirations))
+                ticks += expirations;
+            if(ticks >= 5)
+            {
+                reactor.remove(timer);
+                close(timer);
+                ticked.set();
+            }
+        });
+
+        int counter = eventfd(0, EFD_NONBLOCK);
+        std::atomic<uint64_t> counted(0);
+        WaitFlag counted_all;
+        reactor.add(counter, EPOLLIN, [&] (uint32_t events) {
+            uint64_t value = 0;
+            if(read(counter, &value, sizeof(value)) == sizeof(value) && (counted += value) == 6)
+                counted_all.set();
+        });
+        for(uint64_t i=1; i <= 3; ++i)
+        {
+            if(write(counter, &i, sizeof(i)) != sizeof(i))
+                return 1;
+        }
+
+        ticked.wait(HONEYDEW);
+        counted_all.wait(HONEYDEW);
+        reactor.stop();
+        reactor.remove(counter);
+        close(counter);
+
+        std::cout << "timer ticked " << (ticks >= 5 ? "at least" : "less than") << " 5 times, eventfd counted " << counted << std::endl;
+    }
+
+    // Without a thread of its own, a reactor is polled by a loop the application already runs.
+    // Output: poll posted 1 handler
+    {
+        Reactor reactor(HONEYDEW);
+        int counter = eventfd(0, EFD_NONBLOCK);
+        WaitFlag handled;
+        reactor.add(counter, EPOLLIN, [&] (uint32_t events) {
+            uint64_t value;
+            if(read(counter, &value, sizeof(value)) == sizeof(value))
+                handled.set();
+        });
+
+        uint64_t one = 1;
+        if(write(counter, &one, sizeof(one)) != sizeof(one))
+            return 1;
+
+        size_t posted = reactor.poll(1000);
+        handled.wait(HONEYDEW);
+        reactor.remove(counter);
+        close(counter);
+
+        std::cout << "poll posted " << posted << " handler" << std::endl;
+    }
+
+    // When a bounded Honeydew rejects a handler its fd is re-armed, so the readiness is
+    //   reported again by the next poll once there is room.
+    // Output: first poll rejected, second poll posted 1 handler which ran
+    {
+        Honeydew* BOUNDED = Honeydew::create(Honeydew::ROUND_ROBIN, 1, 1, 1, Honeydew::FAIL);
+        WaitFlag started;
+        WaitFlag gate;
+        BOUNDED->post(Task([&] () {
+            started.set();
+            gate.wait(nullptr);
+        }, 1));
+        started.wait(nullptr);
+        WaitFlag drained;
+        BOUNDED->post(Task([&] () { drained.set(); }, 1));
+
+        Reactor reactor(BOUNDED);
+        int counter = eventfd(0, EFD_NONBLOCK);
+        WaitFlag handled;
+        reactor.add(counter, EPOLLIN, [&] (uint32_t events) {
+            uint64_t value;
+            if(read(counter, &value, sizeof(value)) == sizeof(value))
+                handled.set();
+        });
+
+        uint64_t one = 1;
+        if(write(counter, &one, sizeof(one)) != sizeof(one))
+            return 1;
+
+        bool rejected = false;
+        try
+        {
+            reactor.poll(1000);
+        }
+        catch(std::overflow_error&)
+        {
+            rejected = true;
+        }
+
+        gate.set();
+        drained.wait(nullptr);
+        size_t posted = reactor.poll(1000);
+        handled.wait(nullptr);
+        reactor.remove(counter);
+        close(counter);
+
+        std::cout << "first poll " << (rejected ? "rejected" : "posted") << ", second poll posted " << posted << " handler which ran" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+/**
+* This example shows the typical usage of the Strand and KeyedStrand
+*   (helpers/strand.hpp) helper classes.
+*/
+
+#include <honeydew/honeydew.hpp>
+#include <honeydew/helpers/strand.hpp>
+#include <honeydew/detail/wait_flag.hpp>
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace honeydew;
+
+int main(int argc, char* argv[])
+{
+    Honeydew* HONEYDEW = Honeydew::create(Honeydew::ROUND_ROBIN, 4, 1);
+
+    // Actions posted to a strand never run concurrently and run in post order,
+    //   but may run on any worker. This makes the unsynchronized vector below safe.
+    //   Like the Honeydew, a strand must outlive the actions posted to it.
+    // Output: 1000 values in order
+    Strand* strand = new Strand(HONEYDEW);
+    KeyedStrand<int>* accounts = new KeyedStrand<int>(HONEYDEW, 64);
+
+    {
+        std::vector<int> values;
+        for(int i=0; i < 1000; ++i)
+        {
+            strand->post([&values, i] () { values.push_back(i); });
+        }
+
+        // The last action in the strand wakes up the main thread.
+        WaitFlag complete;
+        strand->post([&] () {
+            bool in_order = true;
+            for(size_t i=0; i < values.size(); ++i)
+            {
+                in_order = in_order && values[i] == static_cast<int>(i);
+            }
+            printf("%lu values %s\n", values.size(), in_order ? "in order" : "OUT OF ORDER");
+            complete.set();
+        });
+        complete.wait(HONEYDEW);
+    }
+
+    // A KeyedStrand serializes per key. Here each balance is only touched by one worker at a time.
+    // Output: 500 500 500 500
+    {
+        int balances[4] = {0, 0, 0, 0};
+        for(int i=0; i < 2000; ++i)
+        {
+            int account = i % 4;
+            accounts->post(account, [&balances, account] () { ++balances[account]; });
+        }
+
+        for(int account=0; account < 4; ++account)
+        {
+            WaitFlag complete;
+            accounts->post(account, [&] () { complete.set(); });
+            complete.wait(HONEYDEW);
+            printf("%d ", balances[account]);
+        }
+        printf("\n");
+    }
+
+    // Many threads posting to a strand at once, with the drain re-posted every 2 actions,
+    //   still never run two of its actions at the same time.
+    // Output: 20000 actions from 4 threads, never overlapping, each thread's in order
+    {
+        Strand busy(HONEYDEW, 0, 0, 2);
+        const int num_threads = 4;
+        const int per_thread = 5000;
+        std::atomic<int> running(0);
+        int overlaps = 0;
+        int out_of_order = 0;
+        int ran = 0;
+        int last[num_threads] = {-1, -1, -1, -1};
+
+        std::vector<std::thread> posters;
+        for(int t=0; t < num_threads; ++t)
+        {
+            posters.push_back(std::thread([&, t] () {
+                for(int i=0; i < per_thread; ++i)
+                {
+                    busy.post([&, t, i] () {
+                        if(running.fetch_add(1) != 0)
+                            ++overlaps;
+                        if(last[t] != i - 1)
+                            ++out_of_order;
+                        last[t] = i;
+                        ++ran;
+                        running.fetch_sub(1);
+                    });
+                }
+            }));
+        }
+        for(size_t t=0; t < posters.size(); ++t)
+            posters[t].join();
+
+        WaitFlag complete;
+        busy.post([&] () { complete.set(); });
+        complete.wait(HONEYDEW);
+        printf("%d actions from %d threads, %s, %s\n", ran, num_threads, overlaps == 0 ? "never overlapping" : "OVERLAPPING",
+               out_of_order == 0 ? "each thread's in order" : "OUT OF ORDER");
+    }
+
+    return 0;
+}
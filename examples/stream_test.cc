@@ -0,0 +1,88 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+/**
+* This example shows the typical usage of the StreamPipeline
+*   (helpers/stream_pipeline.hpp) helper class.
+*/
+
+#include <honeydew/honeydew.hpp>
+#include <honeydew/helpers/stream_pipeline.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace honeydew;
+
+int main(int argc, char* argv[])
+{
+    Honeydew* HONEYDEW = Honeydew::create(Honeydew::ROUND_ROBIN, 4, 1);
+
+    // The stages are declared once and every pushed number flows through them. The squares are
+    //   computed in parallel, the in order stage sees them in push order and the out of order
+    //   stage sums them one at a time. At most 8 numbers are in the pipeline at once.
+    // Output: 10000 squares in order, sum 333283335000
+    {
+        std::vector<uint64_t> squares;
+        uint64_t sum = 0;
+
+        StreamPipeline<uint64_t> numbers(HONEYDEW, 8);
+        auto stream = numbers
+            .then(PARALLEL, [] (uint64_t n) { return n * n; })
+            .then(SERIAL_IN_ORDER, [&squares] (uint64_t square) { squares.push_back(square); return square; })
+            .then(SERIAL_OUT_OF_ORDER, [&sum] (uint64_t square) { sum += square; });
+
+        for(uint64_t i=0; i < 10000; ++i)
+        {
+            stream.push(i);
+        }
+        stream.wait();
+
+        bool in_order = true;
+        for(size_t i=0; i < squares.size(); ++i)
+        {
+            in_order = in_order && squares[i] == i * i;
+        }
+        std::cout << squares.size() << " squares " << (in_order ? "in order" : "OUT OF ORDER") << ", sum " << sum << std::endl;
+    }
+
+    // Items move from stage to stage, so no string is copied after it is pushed.
+    //   An item whose stage throws is dropped without blocking the ordered stages behind it.
+    // Output: abc! ghi!
+    {
+        StreamPipeline<std::string> words(HONEYDEW, 4);
+        auto stream = words
+            .then(PARALLEL, [] (std::string word) {
+                if(word == "def")
+                    throw std::runtime_error("def");
+                return word + "!";
+            })
+            .then(SERIAL_IN_ORDER, [] (std::string word) { std::cout << word << " "; });
+
+        stream.push("abc");
+        stream.push("def");
+        stream.push("ghi");
+        stream.wait();
+        std::cout << std::endl;
+    }
+
+    // Stages are only appended through the handle of the last stage, since one appended to an
+    //   earlier handle would expect that handle's output rather than the last stage's.
+    // Output: Caught: Stages can only be added after the last stage of a StreamPipeline.
+    {
+        StreamPipeline<std::string> lines(HONEYDEW, 4);
+        auto lengths = lines.then(PARALLEL, [] (std::string line) { return line.size(); });
+        try
+        {
+            lines.then(PARALLEL, [] (std::string line) { return line + "!"; });
+        }
+        catch(std::logic_error& e)
+        {
+            std::cout << "Caught: " << e.what() << std::endl;
+        }
+        lengths.wait();
+    }
+
+    return 0;
+}
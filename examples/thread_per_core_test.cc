@@ -0,0 +1,109 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+/**
+* This example shows a THREAD_PER_CORE Honeydew, whose workers share no locks:
+*   tasks between workers travel over a ring per pair of workers.
+*/
+
+#include <honeydew/honeydew.hpp>
+#include <honeydew/helpers/task_wrapper.hpp>
+#include <honeydew/detail/wait_flag.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+
+using namespace honeydew;
+
+int main(int argc, char* argv[])
+{
+    const size_t num_workers = 4;
+    Honeydew* HONEYDEW = Honeydew::create(Honeydew::THREAD_PER_CORE, num_workers, 16, 64);
+
+    // A token is passed from worker to worker around the ring one hop at a time, so each hop
+    //   is a post from one worker to the next. The small rings overflow into the senders' backlogs.
+    // Output: 100000 hops, each on the expected worker
+    {
+        const size_t hops = 100000;
+        std::atomic<size_t> misplaced(0);
+        WaitFlag complete;
+
+        std::function<void(size_t)> hop = [&] (size_t count) {
+            if(HONEYDEW->current_worker_id() != count % num_workers + 1)
+                ++misplaced;
+            if(count + 1 == hops)
+            {
+                complete.set();
+                return;
+            }
+            HONEYDEW->post(Task([&hop, count] () { hop(count + 1); }, (count + 1) % num_workers + 1));
+        };
+
+        HONEYDEW->post(Task([&hop] () { hop(0); }, 1));
+        complete.wait(HONEYDEW);
+
+        std::cout << hops << " hops, " << (misplaced == 0 ? "each on the expected worker" : "some on the wrong worker") << std::endl;
+    }
+
+    // Tasks posted from outside come in through the injection rings and are spread over the
+    //   workers. A fan out from a worker joins back as usual.
+    // Output: 10000 injected tasks ran on 4 workers, fan out of 8 joined
+    {
+        std::atomic<int> ran(0);
+        std::atomic<int> per_worker[num_workers];
+        for(size_t i=0; i < num_workers; ++i)
+            per_worker[i] = 0;
+        WaitFlag injected;
+
+        for(int i=0; i < 10000; ++i)
+        {
+            HONEYDEW->post(Task([&] () {
+                ++per_worker[HONEYDEW->current_worker()];
+                if(++ran == 10000)
+                    injected.set();
+            }));
+        }
+        injected.wait(HONEYDEW);
+
+        size_t used = 0;
+        for(size_t i=0; i < num_workers; ++i)
+            used += per_worker[i] != 0 ? 1 : 0;
+
+        std::atomic<int> branches(0);
+        int joined = 0;
+        WaitFlag complete;
+        Task fan_out([] () {}, 1);
+        for(size_t i=0; i < 8; ++i)
+            fan_out.also([&] () { ++branches; }, i % num_workers + 1);
+        HONEYDEW->post(fan_out.then([&] () {
+            joined = branches;
+            complete.set();
+        }, 2));
+        complete.wait(HONEYDEW);
+
+        std::cout << ran << " injected tasks ran on " << used << " workers, fan out of " << joined << " joined" << std::endl;
+    }
+
+    // Timers are kept by the worker which owns them.
+    // Output: timer fired on worker 3 after at least 50ms
+    {
+        size_t fired_on = 0;
+        WaitFlag complete;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point fired;
+
+        HONEYDEW->post_after(Task([&] () {
+            fired = std::chrono::steady_clock::now();
+            fired_on = HONEYDEW->current_worker_id();
+            complete.set();
+        }, 3), std::chrono::milliseconds(50));
+        complete.wait(HONEYDEW);
+
+        std::cout << "timer fired on worker " << fired_on << " after "
+                  << (fired - start >= std::chrono::milliseconds(50) ? "at least" : "less than") << " 50ms" << std::endl;
+    }
+
+    return 0;
+}
@@ -18,7 +18,7 @@ int main(int argc, char* argv[])
 
     Honeydew* HONEYDEW = Honeydew::create(Honeydew::ROUND_ROBIN, 3, 1);
 
-    Timer<100> t(HONEYDEW); // Specified in nanoseconds.
+    Timer<100> t(HONEYDEW); // 100ms resolution.
     int counter = 0;
 
     std::unique_lock<std::mutex> lg(mut);
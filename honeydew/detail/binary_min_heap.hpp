@@ -28,10 +28,21 @@ public:
         : size(0)
         , capacity(initial_capacity)
         , heap(new T*[initial_capacity])
+        , max_size(0)
     {
         
     }
 
+    /**
+    * Bounds the number of elements held by this heap. Only push_bounded and push_evicting honor it.
+    * @arg max_size the maximum number of elements. 0 is unbounded.
+    */
+    void set_capacity(size_t max_size)
+    {
+        std::unique_lock<std::mutex> lg(m);
+        this->max_size = max_size;
+    }
+
     /**
     * Inserts a new task into this min heap.
     * @arg task the task to insert into the heap, ordered by ->priority.
@@ -40,20 +51,72 @@ public:
     {
         {
             std::unique_lock<std::mutex> lg(m);
+            insert(task);
+        }
+        cd.notify_one();
+    }
 
-            // Make sure we're big enough for this element.
-            grow();
+    /**
+    * Inserts a new task into this min heap unless the heap is full.
+    * @arg task the task to insert into the heap, ordered by ->priority.
+    * @arg wait if true block until there is room instead of failing.
+    * @return true if the task was inserted.
+    */
+    bool push_bounded(T* task, bool wait)
+    {
+        {
+            std::unique_lock<std::mutex> lg(m);
+            while(max_size != 0 && size >= max_size)
+            {
+                if(!wait)
+                    return false;
+                not_full.wait(lg);
+            }
+            insert(task);
+        }
+        cd.notify_one();
+        return true;
+    }
 
-            // Insert ourselves into the index beyond the last used.
-            heap[size] = task;
+    /**
+    * Inserts a new task into this min heap, removing the element with the largest priority
+    *  value first if the heap is full. A heap does not track the age of its elements so this
+    *  is also what happens when the oldest element is asked for.
+    * @arg task the task to insert into the heap, ordered by ->priority.
+    * @arg lowest_priority ignored, see above.
+    * @return the removed element, which is task itself if nothing in the heap has a larger priority
+    *  value, or nullptr if there was room. Internal elements are never removed.
+    */
+    T* push_evicting(T* task, bool lowest_priority)
+    {
+        T* evicted = nullptr;
+        {
+            std::unique_lock<std::mutex> lg(m);
+            if(max_size != 0 && size >= max_size)
+            {
+                // The largest element is one of the leaves, unless it is internal. Then all have to be searched.
+                size_t largest = size;
+                for(size_t i=0; i < size; ++i)
+                {
+                    if(!heap[i]->internal && (largest == size || heap[i]->priority > heap[largest]->priority))
+                        largest = i;
+                }
 
-            // Use sift upon on that index to correct the heap property.
-            siftUp(size);
+                if(largest == size || task->priority >= heap[largest]->priority)
+                    return task;
 
-            // Increase the size to reflect the new size of the heap.
-            ++size;
+                // Replace it with the new task. Its priority value is smaller so only sifting up can be needed.
+                evicted = heap[largest];
+                heap[largest] = task;
+                siftUp(largest);
+            }
+            else
+            {
+                insert(task);
+            }
         }
         cd.notify_one();
+        return evicted;
     }
 
     /**
@@ -73,6 +136,58 @@ public:
             cd.wait(lg);
         }
 
+        return take(step, output);
+    }
+
+    /**
+    * Removes up to step elements from this min-heap. If none are available
+    *   this method blocks until at least one element is ready or the deadline has passed.
+    * @arg step the maximum number of elements to remove.
+    * @arg output a memory location for where to store the output list of tasks.
+    * @arg deadline the std::chrono time point to stop waiting at.
+    * @return the number of tasks gathered. Zero if the deadline passed first.
+    */
+    template<typename TimePoint>
+    size_t pop_until(size_t step, T** output, const TimePoint& deadline)
+    {
+        std::unique_lock<std::mutex> lg(m);
+        while(size == 0)
+        {
+            if(cd.wait_until(lg, deadline) == std::cv_status::timeout && size == 0)
+            {
+                *output = nullptr;
+                return 0;
+            }
+        }
+
+        return take(step, output);
+    }
+
+    /**
+    * Removes up to step elements from this min-heap without blocking.
+    * @arg step the maximum number of elements to remove.
+    * @arg output a memory location for where to store the output list of tasks.
+    * @return the number of tasks gathered. Zero if the heap was empty.
+    */
+    size_t try_pop(size_t step, T** output)
+    {
+        std::unique_lock<std::mutex> lg(m);
+        if(size == 0)
+        {
+            *output = nullptr;
+            return 0;
+        }
+
+        return take(step, output);
+    }
+
+private:
+
+    /**
+    * Removes up to step elements from the non-empty heap. The lock must be held.
+    */
+    size_t take(size_t step, T** output)
+    {
         size_t gathered = 0;
         *output = nullptr;
         T* output_end = nullptr;
@@ -113,10 +228,29 @@ public:
         // Ensure the next of the end is pointing to nullptr.
         output_end->next = nullptr;
 
+        if(max_size != 0)
+            not_full.notify_all();
+
         return gathered;
     }
 
-private:
+    /**
+    * Inserts an element. The lock must be held.
+    */
+    void insert(T* task)
+    {
+        // Make sure we're big enough for this element.
+        grow();
+
+        // Insert ourselves into the index beyond the last used.
+        heap[size] = task;
+
+        // Use sift upon on that index to correct the heap property.
+        siftUp(size);
+
+        // Increase the size to reflect the new size of the heap.
+        ++size;
+    }
 
     inline static size_t parent_index(size_t index) { return (index - 1) / 2; }
     inline static size_t first_index(size_t index) { return 2*index + 1; }
@@ -188,9 +322,11 @@ private:
     size_t size;
     size_t capacity;
     T** heap;
+    size_t max_size;
 
     std::mutex m;
     std::condition_variable cd;
+    std::condition_variable not_full;
 };
 
 }
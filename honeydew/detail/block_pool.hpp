@@ -0,0 +1,275 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <mutex>
+#include <atomic>
+#include <utility>
+#include <type_traits>
+
+namespace honeydew
+{
+
+/**
+* A thread local cache of memory blocks grouped into power of two size classes.
+*  Blocks freed on a different thread than they were allocated on are cached by the
+*  freeing thread. When a thread caches too many blocks of a class it hands a batch of
+*  them to a shared depot, and a thread which runs out takes a batch back, so blocks flow
+*  from the threads which free them to the threads which allocate them with one lock per
+*  batch. Requests larger than the biggest size class go straight to the global allocator.
+*/
+class BlockPool
+{
+public:
+
+    /**
+    * Returns a block of at least size bytes.
+    * @arg size the number of bytes required.
+    */
+    static void* allocate(size_t size)
+    {
+        size_t size_class = class_of(size);
+        if(size_class == num_classes)
+            return ::operator new(size);
+
+        Cache& c = cache();
+        if(c.heads[size_class] == nullptr)
+            refill(c, size_class);
+
+        FreeBlock* block = c.heads[size_class];
+        if(block != nullptr)
+        {
+            c.heads[size_class] = block->next;
+            --c.counts[size_class];
+            return block;
+        }
+        return ::operator new(min_block << size_class);
+    }
+
+    /**
+    * Returns a block to the calling thread's cache.
+    * @arg block the block to return.
+    * @arg size the size which was passed to allocate for this block.
+    */
+    static void deallocate(void* block, size_t size)
+    {
+        size_t size_class = class_of(size);
+        if(size_class == num_classes)
+        {
+            ::operator delete(block);
+            return;
+        }
+
+        Cache& c = cache();
+        FreeBlock* free_block = static_cast<FreeBlock*>(block);
+        free_block->next = c.heads[size_class];
+        c.heads[size_class] = free_block;
+        if(++c.counts[size_class] > max_cached)
+            spill(c, size_class);
+    }
+
+    /**
+    * Constructs a T in a pooled block. Over aligned types use the global allocator.
+    * @arg args the arguments passed to T's constructor.
+    */
+    template<typename T, typename... Args>
+    static T* create(Args&&... args)
+    {
+        void* block = allocate_for<T>(is_poolable<T>());
+        try
+        {
+            return new (block) T(std::forward<Args>(args)...);
+        }
+        catch(...)
+        {
+            deallocate_for<T>(block, is_poolable<T>());
+            throw;
+        }
+    }
+
+    /**
+    * Destroys a T made by create and returns its block.
+    * @arg object the object to destroy.
+    */
+    template<typename T>
+    static void destroy(T* object)
+    {
+        object->~T();
+        deallocate_for<T>(object, is_poolable<T>());
+    }
+
+private:
+    static const size_t min_block = 64;
+    static const size_t num_classes = 8;
+    static const size_t max_cached = 256;
+    static const size_t batch_size = max_cached / 2;
+    static const size_t max_depot_batches = 64;
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+        FreeBlock* next_batch;
+    };
+
+    struct Cache
+    {
+        Cache()
+        {
+            for(size_t i=0; i < num_classes; ++i)
+            {
+                heads[i] = nullptr;
+                counts[i] = 0;
+            }
+        }
+
+        ~Cache()
+        {
+            for(size_t i=0; i < num_classes; ++i)
+            {
+                while(heads[i] != nullptr)
+                {
+                    FreeBlock* next = heads[i]->next;
+                    ::operator delete(heads[i]);
+                    heads[i] = next;
+                }
+            }
+        }
+
+        FreeBlock* heads[num_classes];
+        size_t counts[num_classes];
+    };
+
+    /**
+    * Batches of free blocks shared between threads, chained through the first block of each batch.
+    */
+    struct Depot
+    {
+        Depot()
+        {
+            for(size_t i=0; i < num_classes; ++i)
+            {
+                batches[i] = nullptr;
+                counts[i] = 0;
+            }
+        }
+
+        std::mutex m;
+        FreeBlock* batches[num_classes];
+        std::atomic<size_t> counts[num_classes];
+    };
+
+    static Cache& cache()
+    {
+        static thread_local Cache c;
+        return c;
+    }
+
+    static Depot& depot()
+    {
+        // Never destroyed: workers may still free blocks while static objects are torn down.
+        static Depot* d = new Depot();
+        return *d;
+    }
+
+    /**
+    * Moves a batch of blocks from the cache to the depot (or frees them if the depot is full).
+    */
+    static void spill(Cache& c, size_t size_class)
+    {
+        FreeBlock* first = c.heads[size_class];
+        FreeBlock* last = first;
+        for(size_t i=1; i < batch_size; ++i)
+        {
+            last = last->next;
+        }
+        c.heads[size_class] = last->next;
+        c.counts[size_class] -= batch_size;
+        last->next = nullptr;
+
+        Depot& d = depot();
+        {
+            std::unique_lock<std::mutex> lg(d.m);
+            if(d.counts[size_class] < max_depot_batches)
+            {
+                first->next_batch = d.batches[size_class];
+                d.batches[size_class] = first;
+                ++d.counts[size_class];
+                return;
+            }
+        }
+
+        while(first != nullptr)
+        {
+            FreeBlock* next = first->next;
+            ::operator delete(first);
+            first = next;
+        }
+    }
+
+    /**
+    * Moves a batch of blocks from the depot into the empty cache, if the depot has one.
+    */
+    static void refill(Cache& c, size_t size_class)
+    {
+        // Avoid the lock while the depot has nothing to offer.
+        Depot& d = depot();
+        if(d.counts[size_class].load(std::memory_order_relaxed) == 0)
+            return;
+
+        std::unique_lock<std::mutex> lg(d.m);
+        FreeBlock* batch = d.batches[size_class];
+        if(batch != nullptr)
+        {
+            d.batches[size_class] = batch->next_batch;
+            --d.counts[size_class];
+            c.heads[size_class] = batch;
+            c.counts[size_class] = batch_size;
+        }
+    }
+
+    template<typename T>
+    struct is_poolable : public std::integral_constant<bool, alignof(T) <= alignof(std::max_align_t)>
+    {
+    };
+
+    template<typename T>
+    static void* allocate_for(std::true_type)
+    {
+        return allocate(sizeof(T));
+    }
+
+    template<typename T>
+    static void* allocate_for(std::false_type)
+    {
+        return ::operator new(sizeof(T));
+    }
+
+    template<typename T>
+    static void deallocate_for(void* block, std::true_type)
+    {
+        deallocate(block, sizeof(T));
+    }
+
+    template<typename T>
+    static void deallocate_for(void* block, std::false_type)
+    {
+        ::operator delete(block);
+    }
+
+    static size_t class_of(size_t size)
+    {
+        size_t size_class = 0;
+        size_t block = min_block;
+        while(block < size && size_class < num_classes)
+        {
+            block <<= 1;
+            ++size_class;
+        }
+        return size_class;
+    }
+};
+
+}
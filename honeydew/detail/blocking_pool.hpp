@@ -0,0 +1,138 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+#pragma once
+
+#include <honeydew/task_t.hpp>
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+namespace honeydew
+{
+
+/**
+* An elastic set of threads for tasks which may block. A thread is started whenever a task
+*  arrives and every thread is busy, up to max_threads, and a thread which has been idle for
+*  keep_alive exits. Tasks beyond max_threads wait in FIFO order.
+*  The threads are detached, so the pool must never be destroyed while it has any.
+*/
+class BlockingPool
+{
+public:
+    typedef std::function<void(task_t*)> RunFunc;
+
+    /**
+    * @arg run called on a pool thread for each submitted task. It owns the task from then on.
+    * @arg max_threads the largest number of threads the pool grows to.
+    * @arg keep_alive how long a thread waits for work before exiting.
+    */
+    BlockingPool(RunFunc run, size_t max_threads=64, std::chrono::milliseconds keep_alive=std::chrono::seconds(10))
+        : run(run)
+        , max_threads(max_threads == 0 ? 1 : max_threads)
+        , keep_alive(keep_alive)
+        , head(nullptr)
+        , tail(nullptr)
+        , queued(0)
+        , threads(0)
+        , idle(0)
+    {
+    }
+
+    /**
+    * Deleted copy constructor & copy assignment
+    */
+    BlockingPool(const BlockingPool& other) = delete;
+    BlockingPool& operator=(const BlockingPool& other) = delete;
+
+    /**
+    * Changes the limits. Threads above the new maximum exit once they are idle.
+    */
+    void set_limits(size_t max_threads, std::chrono::milliseconds keep_alive)
+    {
+        std::unique_lock<std::mutex> lg(m);
+        this->max_threads = max_threads == 0 ? 1 : max_threads;
+        this->keep_alive = keep_alive;
+        cv.notify_all();
+    }
+
+    /**
+    * Queues a single task and starts a thread for it if none is free.
+    * This function is thread safe.
+    */
+    void submit(task_t* task)
+    {
+        task->next = nullptr;
+        bool spawn = false;
+        {
+            std::unique_lock<std::mutex> lg(m);
+            if(tail == nullptr)
+                head = task;
+            else
+                tail->next = task;
+            tail = task;
+            ++queued;
+
+            if(queued > idle && threads < max_threads)
+            {
+                ++threads;
+                spawn = true;
+            }
+        }
+
+        if(spawn)
+            std::thread(&BlockingPool::work, this).detach();
+        else
+            cv.notify_one();
+    }
+
+private:
+
+    void work()
+    {
+        std::unique_lock<std::mutex> lg(m);
+        while(true)
+        {
+            while(head == nullptr)
+            {
+                ++idle;
+                bool timed_out = cv.wait_for(lg, keep_alive) == std::cv_status::timeout;
+                --idle;
+
+                if(head == nullptr && (timed_out || threads > max_threads))
+                {
+                    --threads;
+                    return;
+                }
+            }
+
+            task_t* task = head;
+            head = task->next;
+            if(head == nullptr)
+                tail = nullptr;
+            task->next = nullptr;
+            --queued;
+
+            lg.unlock();
+            run(task);
+            lg.lock();
+        }
+    }
+
+    RunFunc run;
+    size_t max_threads;
+    std::chrono::milliseconds keep_alive;
+
+    std::mutex m;
+    std::condition_variable cv;
+    task_t* head;
+    task_t* tail;
+    size_t queued;
+    size_t threads;
+    size_t idle;
+};
+
+}
@@ -40,6 +40,43 @@ public:
         ++n;
     }
 
+    /**
+    * Bounds the number of elements held by the underlying queue.
+    * @param capacity the maximum number of elements. 0 is unbounded.
+    */
+    void set_capacity(size_t capacity)
+    {
+        q.set_capacity(capacity);
+    }
+
+    /**
+    * Adds this task to the internal queue unless it is full and increments the size if it was added.
+    * @param task the task to add.
+    * @param wait if true block until there is room instead of failing.
+    * @return true if the task was added.
+    */
+    bool push_bounded(typename QueueType::value_type* task, bool wait)
+    {
+        if(!q.push_bounded(task, wait))
+            return false;
+        ++n;
+        return true;
+    }
+
+    /**
+    * Adds this task to the internal queue, removing another element if it is full.
+    * @param task the task to add.
+    * @param lowest_priority selects the element removed. See the underlying queue.
+    * @return the removed element, which may be task itself, or nullptr if there was room.
+    */
+    typename QueueType::value_type* push_evicting(typename QueueType::value_type* task, bool lowest_priority)
+    {
+        typename QueueType::value_type* evicted = q.push_evicting(task, lowest_priority);
+        if(evicted == nullptr)
+            ++n;
+        return evicted;
+    }
+
     /**
     * Removes up to step elements from the queue and decrements the size accordingly.
     * @param step the number of elements to try and remove.
@@ -55,6 +92,38 @@ public:
         return step;
     }
 
+    /**
+    * Removes up to step elements from the queue, waiting no later than the deadline, and decrements the size accordingly.
+    * @param step the number of elements to try and remove.
+    * @param result a pointer to a location to store the first output task.
+    * @param deadline the std::chrono time point to stop waiting at.
+    * @pre None
+    * @post Up to step tasks is removed from the internal queue and size is decremented accordingly.
+    * @return the number of tasks effectively removed. Zero if the deadline passed first.
+    */
+    template<typename TimePoint>
+    size_t pop_until(size_t step, typename QueueType::value_type **result, const TimePoint& deadline)
+    {
+        step = q.pop_until(step, result, deadline);
+        n.fetch_sub(step);
+        return step;
+    }
+
+    /**
+    * Removes up to step elements from the queue without blocking and decrements the size accordingly.
+    * @param step the number of elements to try and remove.
+    * @param result a pointer to a location to store the first output task.
+    * @pre None
+    * @post Up to step tasks is removed from the internal queue and size is decremented accordingly.
+    * @return the number of tasks effectively removed. Zero if the queue was empty.
+    */
+    size_t try_pop(size_t step, typename QueueType::value_type **result)
+    {
+        step = q.try_pop(step, result);
+        n.fetch_sub(step);
+        return step;
+    }
+
     /**
     * Returns the current size of the underlying queue.
     *   (This function is not strictly atomic)
@@ -0,0 +1,92 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+#pragma once
+
+#include <atomic>
+
+namespace honeydew
+{
+
+/**
+* An intrusive, lock-free, multiple producer single consumer queue.
+*  T must have a std::atomic<T*> next member and be default constructible (for the stub node).
+*  push never blocks. pop may briefly report an empty queue while a push is half way done;
+*  callers which need to know that every pushed element has been seen should keep their own count.
+*/
+template<typename T>
+class MpscQueue
+{
+public:
+
+    MpscQueue()
+        : head(&stub)
+        , tail(&stub)
+    {
+        stub.next.store(nullptr);
+    }
+
+    /**
+    * Deleted copy constructor & copy assignment
+    */
+    MpscQueue(const MpscQueue& other) = delete;
+    MpscQueue& operator=(const MpscQueue& other) = delete;
+
+    /**
+    * Adds an element to the back of the queue.
+    * This function is thread safe.
+    * @arg node the element to add.
+    */
+    void push(T* node)
+    {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        T* prev = head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    /**
+    * Removes the element at the front of the queue.
+    * Only one thread may pop at a time.
+    * @return the element, or nullptr if none is ready.
+    */
+    T* pop()
+    {
+        T* first = tail;
+        T* next = first->next.load(std::memory_order_acquire);
+
+        if(first == &stub)
+        {
+            if(next == nullptr)
+                return nullptr;
+            tail = next;
+            first = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if(next != nullptr)
+        {
+            tail = next;
+            return first;
+        }
+
+        // first is the last element. Unless a push is in progress put the stub behind it so it can be taken.
+        if(first != head.load(std::memory_order_acquire))
+            return nullptr;
+
+        push(&stub);
+        next = first->next.load(std::memory_order_acquire);
+        if(next != nullptr)
+        {
+            tail = next;
+            return first;
+        }
+        return nullptr;
+    }
+
+private:
+    std::atomic<T*> head;
+    T* tail;
+    T stub;
+};
+
+}
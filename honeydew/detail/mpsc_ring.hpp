@@ -0,0 +1,122 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace honeydew
+{
+
+/**
+* A bounded, lock-free, multiple producer single consumer ring of pointers.
+*  Every slot carries a sequence number telling producers and the consumer whose turn it is,
+*  so producers only contend on the tail index and never wait for each other to finish.
+*/
+template<typename T>
+class MpscRing
+{
+public:
+
+    /**
+    * Constructs an empty ring.
+    * @arg capacity the number of slots, rounded up to a power of two.
+    */
+    explicit MpscRing(size_t capacity)
+        : head(0)
+        , tail(0)
+    {
+        size_t size = 1;
+        while(size < capacity)
+            size <<= 1;
+        slots.reset(new Slot[size]);
+        for(size_t i=0; i < size; ++i)
+        {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        mask = size - 1;
+    }
+
+    /**
+    * Deleted copy constructor & copy assignment
+    */
+    MpscRing(const MpscRing& other) = delete;
+    MpscRing& operator=(const MpscRing& other) = delete;
+
+    /**
+    * Adds an element to the back of the ring.
+    * This function is thread safe.
+    * @arg item the element to add.
+    * @return false if the ring is full.
+    */
+    bool try_push(T* item)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        while(1)
+        {
+            Slot& slot = slots[t & mask];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if(sequence == t)
+            {
+                if(tail.compare_exchange_weak(t, t + 1, std::memory_order_relaxed))
+                {
+                    slot.item = item;
+                    slot.sequence.store(t + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if(static_cast<std::ptrdiff_t>(sequence - t) < 0)
+            {
+                return false;
+            }
+            else
+            {
+                t = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+    * Removes the element at the front of the ring. Only one thread may pop.
+    * @return the element, or nullptr if the ring is empty (or its front is still being written).
+    */
+    T* try_pop()
+    {
+        Slot& slot = slots[head & mask];
+        if(slot.sequence.load(std::memory_order_acquire) != head + 1)
+            return nullptr;
+
+        T* item = slot.item;
+        slot.sequence.store(head + mask + 1, std::memory_order_release);
+        ++head;
+        return item;
+    }
+
+    /**
+    * Returns true if the ring holds no elements. Only meaningful for the popping thread.
+    */
+    bool empty() const
+    {
+        return slots[head & mask].sequence.load(std::memory_order_acquire) != head + 1;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        T* item;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+
+    char padding0[64];
+    size_t head;
+    char padding1[64];
+    std::atomic<size_t> tail;
+    char padding2[64];
+};
+
+}
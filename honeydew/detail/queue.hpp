@@ -27,9 +27,21 @@ public:
     Queue()
         : first(nullptr)
         , last(nullptr)
+        , count(0)
+        , capacity(0)
     {
     }
 
+    /**
+    * Bounds the number of elements held by this queue. Only push_bounded and push_evicting honor it.
+    * @param capacity the maximum number of elements. 0 is unbounded.
+    */
+    void set_capacity(size_t capacity)
+    {
+        std::unique_lock<std::mutex> lg(m);
+        this->capacity = capacity;
+    }
+
     /**
     * Pushes a task onto the end of the queue.
     * @param task the task to push onto the queue.
@@ -40,17 +52,79 @@ public:
     {
         {
             std::unique_lock<std::mutex> lg(m);
-            if(first == nullptr)
+            link(task);
+        }
+        cd.notify_all();
+    }
+
+    /**
+    * Pushes a task onto the end of the queue unless the queue is full.
+    * @param task the task to push onto the queue.
+    * @param wait if true block until there is room instead of failing.
+    * @return true if the task was pushed.
+    */
+    bool push_bounded(T* task, bool wait)
+    {
+        {
+            std::unique_lock<std::mutex> lg(m);
+            while(capacity != 0 && count >= capacity)
             {
-                first = last = task;
+                if(!wait)
+                    return false;
+                not_full.wait(lg);
             }
-            else
+            link(task);
+        }
+        cd.notify_all();
+        return true;
+    }
+
+    /**
+    * Pushes a task onto the end of the queue, removing another element first if the queue is full.
+    * @param task the task to push onto the queue.
+    * @param lowest_priority if true the element with the largest priority value is removed, otherwise the oldest.
+    *  The new task counts as the newest element, so it is the one returned if no queued element has a larger
+    *  priority value. Internal elements are never removed: if every queued element is internal the new task is.
+    * @return the removed element, which may be task itself, or nullptr if there was room.
+    */
+    T* push_evicting(T* task, bool lowest_priority)
+    {
+        T* evicted = nullptr;
+        {
+            std::unique_lock<std::mutex> lg(m);
+            if(capacity != 0 && count >= capacity)
             {
-                last->next = task;
-                last = task;
+                // Find the oldest element, or the last one with the largest priority value, and the one before it.
+                T* previous = nullptr;
+                for(T* prev = nullptr, *current = first; current != nullptr; prev = current, current = current->next)
+                {
+                    if(current->internal)
+                        continue;
+                    if(evicted == nullptr || (lowest_priority && current->priority >= evicted->priority))
+                    {
+                        evicted = current;
+                        previous = prev;
+                        if(!lowest_priority)
+                            break;
+                    }
+                }
+
+                if(evicted == nullptr || (lowest_priority && task->priority >= evicted->priority))
+                    return task;
+
+                if(previous == nullptr)
+                    first = evicted->next;
+                else
+                    previous->next = evicted->next;
+                if(last == evicted)
+                    last = previous;
+                evicted->next = nullptr;
+                --count;
             }
+            link(task);
         }
         cd.notify_all();
+        return evicted;
     }
 
     /**
@@ -70,7 +144,80 @@ public:
             cd.wait(lg);
         }
 
-        size_t gathered = 0;
+        return take(step, output);
+    }
+
+    /**
+    * Attempts to retrieve step elements from this queue.
+    *  This function will block until at least 1 element is ready or the deadline has passed.
+    * @arg step the number of elements to try and remove.
+    * @arg output a memory location to use to store a pointer to the first ready element.
+    * @arg deadline the std::chrono time point to stop waiting at.
+    * @pre None
+    * @post A linked list of exactly return value number of elements is in the output param.
+    * @return the number of elements returned into the output. Zero if the deadline passed first.
+    */
+    template<typename TimePoint>
+    size_t pop_until(size_t step, T** output, const TimePoint& deadline)
+    {
+        std::unique_lock<std::mutex> lg(m);
+        while(first == nullptr)
+        {
+            if(cd.wait_until(lg, deadline) == std::cv_status::timeout && first == nullptr)
+            {
+                *output = nullptr;
+                return 0;
+            }
+        }
+
+        return take(step, output);
+    }
+
+    /**
+    * Attempts to retrieve step elements from this queue without blocking.
+    * @arg step the number of elements to try and remove.
+    * @arg output a memory location to use to store a pointer to the first ready element.
+    * @pre None
+    * @post A linked list of exactly return value number of elements is in the output param.
+    * @return the number of elements returned into the output. Zero if the queue was empty.
+    */
+    size_t try_pop(size_t step, T** output)
+    {
+        std::unique_lock<std::mutex> lg(m);
+        if(first == nullptr)
+        {
+            *output = nullptr;
+            return 0;
+        }
+
+        return take(step, output);
+    }
+
+private:
+
+    /**
+    * Appends an element. The lock must be held.
+    */
+    void link(T* task)
+    {
+        if(first == nullptr)
+        {
+            first = last = task;
+        }
+        else
+        {
+            last->next = task;
+            last = task;
+        }
+        ++count;
+    }
+
+    /**
+    * Unlinks up to step elements from the front of the non-empty queue. The lock must be held.
+    */
+    size_t take(size_t step, T** output)
+    {
+        size_t gathered = 1;
         *output = first;
         T* current = first->next;
         T* output_end = first;
@@ -87,14 +234,20 @@ public:
         if(first == nullptr)
             last = nullptr;
 
+        count -= gathered;
+        if(capacity != 0)
+            not_full.notify_all();
+
         return gathered;
     }
 
-private:
     std::mutex m;
     std::condition_variable cd;
+    std::condition_variable not_full;
     T* first;
     T* last;
+    size_t count;
+    size_t capacity;
 };
 
 }
@@ -0,0 +1,82 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+namespace honeydew
+{
+
+/**
+* A minimal read-copy-update domain.
+*  Readers bracket their access to a shared pointer with read_lock/read_unlock, which is
+*   wait-free (one atomic increment and decrement). Writers publish a new version of the data,
+*   call synchronize, and may then free the old version since no reader can still see it.
+*  Read sections are expected to be short (a lookup and a reference count increment).
+*/
+class RcuDomain
+{
+public:
+
+    RcuDomain()
+        : epoch(0)
+    {
+        readers[0].count = 0;
+        readers[1].count = 0;
+    }
+
+    /**
+    * Deleted copy constructor & copy assignment
+    */
+    RcuDomain(const RcuDomain& other) = delete;
+    RcuDomain& operator=(const RcuDomain& other) = delete;
+
+    /**
+    * Enters a read section.
+    * @return a token which has to be given to read_unlock.
+    */
+    size_t read_lock()
+    {
+        size_t token = epoch.load() & 1;
+        readers[token].count.fetch_add(1);
+        return token;
+    }
+
+    /**
+    * Leaves a read section.
+    * @arg token the value returned by the matching read_lock.
+    */
+    void read_unlock(size_t token)
+    {
+        readers[token].count.fetch_sub(1);
+    }
+
+    /**
+    * Waits until every read section which might have seen a previously published version
+    *  has ended. Writers must be serialized by the caller.
+    */
+    void synchronize()
+    {
+        // Two flips are needed: a reader which sampled the epoch just before the first flip
+        //   may register with the old parity after it was seen drained.
+        for(size_t i=0; i < 2; ++i)
+        {
+            size_t old = epoch.fetch_add(1) & 1;
+            while(readers[old].count.load() != 0)
+                std::this_thread::yield();
+        }
+    }
+
+private:
+    struct alignas(64) Counter
+    {
+        std::atomic<size_t> count;
+    };
+
+    std::atomic<size_t> epoch;
+    Counter readers[2];
+};
+
+}
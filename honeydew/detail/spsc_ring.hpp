@@ -0,0 +1,106 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace honeydew
+{
+
+/**
+* A bounded, lock-free, single producer single consumer ring of pointers.
+*  Each side keeps a private copy of the other side's index and only reloads it when the
+*  ring looks full (or empty), so in the steady state push and pop touch no shared cache line
+*  besides the slot itself.
+*/
+template<typename T>
+class SpscRing
+{
+public:
+
+    /**
+    * Constructs an empty ring.
+    * @arg capacity the number of slots, rounded up to a power of two.
+    */
+    explicit SpscRing(size_t capacity)
+        : head(0)
+        , cached_tail(0)
+        , tail(0)
+        , cached_head(0)
+    {
+        size_t size = 1;
+        while(size < capacity)
+            size <<= 1;
+        slots.resize(size, nullptr);
+        mask = size - 1;
+    }
+
+    /**
+    * Deleted copy constructor & copy assignment
+    */
+    SpscRing(const SpscRing& other) = delete;
+    SpscRing& operator=(const SpscRing& other) = delete;
+
+    /**
+    * Adds an element to the back of the ring. Only the producer may call this.
+    * @arg item the element to add.
+    * @return false if the ring is full.
+    */
+    bool try_push(T* item)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if(t - cached_head > mask)
+        {
+            cached_head = head.load(std::memory_order_acquire);
+            if(t - cached_head > mask)
+                return false;
+        }
+        slots[t & mask] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+    * Removes the element at the front of the ring. Only the consumer may call this.
+    * @return the element, or nullptr if the ring is empty.
+    */
+    T* try_pop()
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if(h == cached_tail)
+        {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if(h == cached_tail)
+                return nullptr;
+        }
+        T* item = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return item;
+    }
+
+    /**
+    * Returns true if the ring holds no elements. Exact for the consumer, a hint for anyone else.
+    */
+    bool empty() const
+    {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    std::vector<T*> slots;
+    size_t mask;
+
+    // The consumer's side and the producer's side live on separate cache lines.
+    char padding0[64];
+    std::atomic<size_t> head;
+    size_t cached_tail;
+    char padding1[64];
+    std::atomic<size_t> tail;
+    size_t cached_head;
+    char padding2[64];
+};
+
+}
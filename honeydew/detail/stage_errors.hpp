@@ -0,0 +1,22 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+#pragma once
+
+#include <exception>
+#include <vector>
+
+namespace honeydew
+{
+
+/**
+* Thrown by a task made of several fused stages (see Task::fuse) when more than one of them
+*  threw. The scheduler passes each exception on to the exception handler in stage order,
+*  just as it would have if the stages had run as separate tasks.
+*/
+struct StageErrors
+{
+    std::vector<std::exception_ptr> errors;
+};
+
+}
@@ -0,0 +1,288 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace honeydew
+{
+
+/**
+* The intrusive part of an element of a TimingWheel.
+*  Users derive from this and set expiry (in ticks) before inserting.
+*/
+struct TimingWheelNode
+{
+    TimingWheelNode()
+        : prev(nullptr)
+        , next(nullptr)
+        , expiry(0)
+    {
+    }
+
+    /**
+    * Returns true if this node is currently in a wheel.
+    */
+    bool linked() const
+    {
+        return next != nullptr;
+    }
+
+    TimingWheelNode* prev;
+    TimingWheelNode* next;
+    uint64_t expiry;
+};
+
+/**
+* A hierarchical timing wheel. Level 0 has one slot per tick, each following level has
+*  one slot per full turn of the level below it. Nodes are kept in intrusive doubly linked
+*  lists so insert and remove are O(1) regardless of the number of pending timers, and
+*  a node is only moved when its slot's turn comes (at most once per level).
+*  This class is not thread safe.
+*/
+class TimingWheel
+{
+public:
+    static const size_t slot_bits = 8;
+    static const size_t num_slots = 1 << slot_bits;
+    static const size_t num_levels = 4;
+
+    /**
+    * Constructs an empty wheel starting at the given tick.
+    * @arg now the current tick.
+    */
+    TimingWheel(uint64_t now)
+        : current(now)
+        , count(0)
+    {
+        for(size_t level=0; level < num_levels; ++level)
+        {
+            for(size_t slot=0; slot < num_slots; ++slot)
+            {
+                TimingWheelNode& head = slots[level][slot];
+                head.prev = head.next = &head;
+            }
+        }
+    }
+
+    /**
+    * Deleted copy constructor & copy assignment (the slot heads are self referencing)
+    */
+    TimingWheel(const TimingWheel& other) = delete;
+    TimingWheel& operator=(const TimingWheel& other) = delete;
+
+    /**
+    * Returns the tick the wheel has advanced to.
+    */
+    uint64_t now() const
+    {
+        return current;
+    }
+
+    /**
+    * Returns the number of nodes in the wheel.
+    */
+    size_t size() const
+    {
+        return count;
+    }
+
+    /**
+    * Inserts a node. Nodes whose expiry has already passed expire on the next advance.
+    * @arg node the node to insert. node->expiry must be set.
+    */
+    void insert(TimingWheelNode* node)
+    {
+        link(node);
+        ++count;
+    }
+
+    /**
+    * Removes a node from the wheel.
+    * @arg node a node which is currently in this wheel.
+    */
+    void remove(TimingWheelNode* node)
+    {
+        unlink(node);
+        --count;
+    }
+
+    /**
+    * Advances the wheel to the given tick, calling on_expired for every node whose expiry
+    *  is at or before that tick. Nodes are removed before on_expired is called, so it may
+    *  re-insert them.
+    * @arg tick the tick to advance to.
+    * @arg on_expired a functor taking a TimingWheelNode*.
+    */
+    template<typename FunctorType>
+    void advance(uint64_t tick, FunctorType on_expired)
+    {
+        // Nodes inserted with an expiry in the past sit in the current slot.
+        expire(slots[0][current & mask], on_expired);
+
+        while(current < tick)
+        {
+            if(count == 0)
+            {
+                current = tick;
+                break;
+            }
+
+            // Skip the ticks on which nothing expires or cascades.
+            if(empty(slots[0][(current + 1) & mask]))
+            {
+                uint64_t next;
+                next_tick(&next);
+                if(next > tick)
+                    next = tick;
+                if(next > current + 1)
+                    current = next - 1;
+            }
+
+            ++current;
+            if((current & mask) == 0)
+                cascade(1);
+
+            expire(slots[0][current & mask], on_expired);
+        }
+    }
+
+    /**
+    * Finds the next tick at which advance has work to do: either an expiry or the moment
+    *  a slot of a higher level has to be moved down. This is never later than the earliest
+    *  expiry, so sleeping until it never misses a timer.
+    * @arg tick output location for the tick.
+    * @return false if the wheel is empty.
+    */
+    bool next_tick(uint64_t* tick) const
+    {
+        if(count == 0)
+            return false;
+
+        if(!empty(slots[0][current & mask]))
+        {
+            *tick = current;
+            return true;
+        }
+
+        // Only nodes beyond the range of the wheel remaining means waking at the next turn of the top level.
+        size_t top_shift = (num_levels - 1) * slot_bits;
+        uint64_t earliest = ((current >> top_shift) + num_slots) << top_shift;
+
+        for(size_t level=0; level < num_levels; ++level)
+        {
+            size_t shift = level * slot_bits;
+            uint64_t position = current >> shift;
+            // A full turn ahead is the current slot, which above level 0 only holds nodes of the next turn.
+            for(uint64_t offset=1; offset <= num_slots; ++offset)
+            {
+                if(!empty(slots[level][(position + offset) & mask]))
+                {
+                    uint64_t candidate = (position + offset) << shift;
+                    if(candidate < earliest)
+                        earliest = candidate;
+                    break;
+                }
+            }
+        }
+
+        *tick = earliest;
+        return true;
+    }
+
+private:
+    static const uint64_t mask = num_slots - 1;
+
+    static bool empty(const TimingWheelNode& head)
+    {
+        return head.next == &head;
+    }
+
+    void link(TimingWheelNode* node)
+    {
+        uint64_t expiry = node->expiry > current ? node->expiry : current;
+        uint64_t delta = expiry - current;
+
+        size_t level = 0;
+        while(level < num_levels - 1 && delta >= (uint64_t(1) << ((level + 1) * slot_bits)))
+        {
+            ++level;
+        }
+
+        // Clamp nodes beyond the range of the wheel to its farthest slot.
+        uint64_t range = uint64_t(1) << (num_levels * slot_bits);
+        if(delta >= range)
+            expiry = current + range - 1;
+
+        TimingWheelNode& head = slots[level][(expiry >> (level * slot_bits)) & mask];
+        node->next = &head;
+        node->prev = head.prev;
+        head.prev->next = node;
+        head.prev = node;
+    }
+
+    static void unlink(TimingWheelNode* node)
+    {
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
+        node->prev = node->next = nullptr;
+    }
+
+    /**
+    * Moves the nodes of the current slot of the given level down, cascading the level above
+    *  first when this level has wrapped around.
+    */
+    void cascade(size_t level)
+    {
+        if(level >= num_levels)
+            return;
+
+        size_t index = (current >> (level * slot_bits)) & mask;
+        if(index == 0)
+            cascade(level + 1);
+
+        TimingWheelNode& head = slots[level][index];
+        if(empty(head))
+            return;
+
+        TimingWheelNode* node = head.next;
+        head.prev->next = nullptr;
+        head.prev = head.next = &head;
+
+        while(node != nullptr)
+        {
+            TimingWheelNode* next = node->next;
+            link(node);
+            node = next;
+        }
+    }
+
+    template<typename FunctorType>
+    void expire(TimingWheelNode& head, FunctorType& on_expired)
+    {
+        // Detach the whole slot first so on_expired may insert into it again.
+        if(empty(head))
+            return;
+
+        TimingWheelNode* node = head.next;
+        head.prev->next = nullptr;
+        head.prev = head.next = &head;
+
+        while(node != nullptr)
+        {
+            TimingWheelNode* next = node->next;
+            node->prev = node->next = nullptr;
+            --count;
+            on_expired(node);
+            node = next;
+        }
+    }
+
+    TimingWheelNode slots[num_levels][num_slots];
+    uint64_t current;
+    size_t count;
+};
+
+}
@@ -0,0 +1,98 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+#pragma once
+
+#include <honeydew/honeydew.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+namespace honeydew
+{
+
+/**
+* A one-shot flag which threads can wait on without idling a worker.
+*  Setting the flag is lock-free unless a thread is actually sleeping on it.
+*/
+class WaitFlag
+{
+public:
+
+    /**
+    * Constructs an unset flag.
+    */
+    WaitFlag()
+        : flags(0)
+    {
+    }
+
+    /**
+    * Returns true if the flag has been set.
+    */
+    bool is_set() const
+    {
+        return (flags.load(std::memory_order_acquire) & SET) != 0;
+    }
+
+    /**
+    * Sets the flag and wakes any sleeping waiter. Once a waiter has observed the flag it may
+    *  destroy it, so nothing is touched after the flag becomes visible.
+    */
+    void set()
+    {
+        unsigned int expected = 0;
+        if(flags.compare_exchange_strong(expected, SET, std::memory_order_acq_rel))
+            return;
+
+        // A waiter is sleeping. Publish while holding the lock so it can't wake early.
+        std::unique_lock<std::mutex> lg(m);
+        flags.fetch_or(SET, std::memory_order_acq_rel);
+        cd.notify_all();
+    }
+
+    /**
+    * Blocks until the flag is set.
+    *  If the calling thread is a worker of the given Honeydew it keeps running tasks from its
+    *   own queue while waiting, so the work being waited on can't be stuck behind the waiter.
+    *  Otherwise the thread spins for up to spin_count iterations before going to sleep.
+    * @arg honeydew the Honeydew whose tasks set the flag. May be nullptr.
+    * @arg spin_count the number of times a foreign thread checks the flag before sleeping.
+    */
+    void wait(Honeydew* honeydew, size_t spin_count=0)
+    {
+        if(honeydew != nullptr && honeydew->current_worker() != Honeydew::no_worker)
+        {
+            while(!is_set())
+            {
+                if(!honeydew->help())
+                    std::this_thread::yield();
+            }
+            return;
+        }
+
+        for(size_t i=0; i < spin_count; ++i)
+        {
+            if(is_set())
+                return;
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> lg(m);
+        if(flags.fetch_or(WAITING, std::memory_order_acq_rel) & SET)
+            return;
+        while(!is_set())
+            cd.wait(lg);
+    }
+
+private:
+    enum { SET = 1, WAITING = 2 };
+
+    std::atomic<unsigned int> flags;
+    std::mutex m;
+    std::condition_variable cd;
+};
+
+}
@@ -0,0 +1,363 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+#pragma once
+
+#if !defined(__cpp_impl_coroutine)
+#error "honeydew/helpers/coroutine.hpp requires a compiler with C++20 coroutine support."
+#endif
+
+#include <honeydew/honeydew.hpp>
+#include <honeydew/helpers/task_wrapper.hpp>
+#include <honeydew/helpers/future.hpp>
+#include <honeydew/detail/block_pool.hpp>
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace honeydew
+{
+
+namespace detail
+{
+
+/**
+* Holds an exception which escaped a detached coroutine on the calling thread until
+*  resume_coroutine can rethrow it to the Honeydew.
+*/
+inline std::exception_ptr& detached_coroutine_error()
+{
+    static thread_local std::exception_ptr error;
+    return error;
+}
+
+/**
+* Resumes the given coroutine on the calling thread. If a detached coroutine finished
+*  with an exception during the resume it is rethrown so the Honeydew's exception handler
+*  receives it like any other task exception.
+*/
+inline void resume_coroutine(std::coroutine_handle<> handle)
+{
+    handle.resume();
+
+    std::exception_ptr& error = detached_coroutine_error();
+    if(error != nullptr)
+    {
+        std::exception_ptr e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+/**
+* Creates a task_t which resumes the given coroutine. It is internal, so a bounded Honeydew
+*  never drops it and leaks the coroutine's frame.
+*/
+inline task_t* make_resume_task(std::coroutine_handle<> handle, size_t worker, uint64_t priority)
+{
+    task_t* task = new task_t([handle] () { resume_coroutine(handle); }, worker, priority);
+    task->internal = true;
+    return task;
+}
+
+/**
+* The parts of a Coroutine's promise which do not depend on the result type.
+*  Coroutine frames are allocated from the BlockPool.
+*/
+struct CoroutinePromiseBase
+{
+    /**
+    * When a coroutine finishes it transfers directly into the coroutine awaiting it (if any),
+    *  otherwise a detached coroutine destroys its own frame.
+    */
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        template<typename PromiseType>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<PromiseType> handle) noexcept
+        {
+            CoroutinePromiseBase& promise = handle.promise();
+            if(promise.continuation)
+                return promise.continuation;
+
+            if(promise.detached)
+            {
+                if(promise.error != nullptr)
+                    detached_coroutine_error() = promise.error;
+                handle.destroy();
+            }
+            return std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept
+        {
+        }
+    };
+
+    std::suspend_always initial_suspend() const noexcept
+    {
+        return {};
+    }
+
+    FinalAwaiter final_suspend() const noexcept
+    {
+        return {};
+    }
+
+    void unhandled_exception()
+    {
+        error = std::current_exception();
+    }
+
+    static void* operator new(size_t size)
+    {
+        return BlockPool::allocate(size);
+    }
+
+    static void operator delete(void* frame, size_t size)
+    {
+        BlockPool::deallocate(frame, size);
+    }
+
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+    bool detached = false;
+};
+
+template<typename T>
+struct CoroutinePromise : public CoroutinePromiseBase
+{
+    template<typename ValueType>
+    void return_value(ValueType&& value)
+    {
+        result.emplace(std::forward<ValueType>(value));
+    }
+
+    T take_result()
+    {
+        if(error != nullptr)
+            std::rethrow_exception(error);
+        return std::move(*result);
+    }
+
+    std::optional<T> result;
+};
+
+template<>
+struct CoroutinePromise<void> : public CoroutinePromiseBase
+{
+    void return_void()
+    {
+    }
+
+    void take_result()
+    {
+        if(error != nullptr)
+            std::rethrow_exception(error);
+    }
+};
+
+}
+
+/**
+* A coroutine which runs as Honeydew tasks. Coroutines are lazy: they start when they are
+*  posted to a Honeydew (which detaches them) or when another coroutine awaits them.
+*  Usage is expected to be like:
+*
+*    Coroutine<int> compute(Honeydew* honeydew)
+*    {
+*        co_await schedule(honeydew, 2);   // Continue on worker 2.
+*        int value = co_await post_future(honeydew, [] () { return 5; });
+*        co_return value + 1;
+*    }
+*/
+template<typename T=void>
+class Coroutine
+{
+public:
+
+    struct promise_type : public detail::CoroutinePromise<T>
+    {
+        Coroutine get_return_object()
+        {
+            return Coroutine(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+    };
+
+    /**
+    * Deleted copy constructor & copy assignment
+    */
+    Coroutine(const Coroutine& other) = delete;
+    Coroutine& operator=(const Coroutine& other) = delete;
+
+    /**
+    * Move constructor.
+    */
+    Coroutine(Coroutine&& other)
+        : handle(std::exchange(other.handle, nullptr))
+    {
+    }
+
+    /**
+    * Destroys the coroutine frame if this object still owns it.
+    */
+    ~Coroutine()
+    {
+        if(handle)
+            handle.destroy();
+    }
+
+    /**
+    * Awaiting a coroutine starts it on the current thread. The awaiting coroutine is resumed
+    *  directly (without a post) when it completes.
+    */
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+
+    T await_resume()
+    {
+        return handle.promise().take_result();
+    }
+
+    /**
+    * Detaches the coroutine from this object and returns a task_t* which starts it. The frame
+    *  is destroyed when the coroutine completes. The result (if any) is discarded and an
+    *  escaping exception is passed to the Honeydew's exception handler.
+    * @arg worker the worker to start the coroutine upon. Worker=0 means any worker.
+    * @arg priority the priority of the starting task.
+    * @return the task_t* generated and ready to be pushed to a Honeydew.
+    */
+    task_t* close(size_t worker=0, uint64_t priority=0)
+    {
+        std::coroutine_handle<promise_type> detached = std::exchange(handle, nullptr);
+        detached.promise().detached = true;
+        return detail::make_resume_task(detached, worker, priority);
+    }
+
+private:
+    explicit Coroutine(std::coroutine_handle<promise_type> handle)
+        : handle(handle)
+    {
+    }
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+/**
+* Awaitable which suspends the awaiting coroutine and resumes it as a task on the given worker.
+*/
+struct ScheduleAwaiter
+{
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> awaiting)
+    {
+        honeydew->post(detail::make_resume_task(awaiting, worker, priority));
+    }
+
+    void await_resume() const noexcept
+    {
+    }
+
+    Honeydew* honeydew;
+    size_t worker;
+    uint64_t priority;
+};
+
+/**
+* Used as co_await schedule(honeydew, worker, priority) to continue a coroutine as a task.
+* @arg honeydew the Honeydew to continue on.
+* @arg worker the worker to continue on. Worker=0 means any worker.
+* @arg priority the priority of the continuation.
+*/
+inline ScheduleAwaiter schedule(Honeydew* honeydew, size_t worker=0, uint64_t priority=0)
+{
+    return ScheduleAwaiter{honeydew, worker, priority};
+}
+
+/**
+* Awaitable which posts a Task and resumes the awaiting coroutine once the Task (including
+*  all of its then/also relationships) has completed. No worker blocks while waiting.
+*/
+struct TaskAwaiter
+{
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> awaiting)
+    {
+        honeydew->post(task.then([awaiting] () { detail::resume_coroutine(awaiting); }, worker, priority));
+    }
+
+    void await_resume() const noexcept
+    {
+    }
+
+    Honeydew* honeydew;
+    Task task;
+    size_t worker;
+    uint64_t priority;
+};
+
+/**
+* Used as co_await post_and_await(honeydew, Task(...)) to run a Task from a coroutine.
+* @arg honeydew the Honeydew to post the task to.
+* @arg task the task to post.
+* @arg worker the worker the coroutine continues on. Worker=0 means any worker.
+* @arg priority the priority of the continuation (added to the previous task's priority).
+*/
+inline TaskAwaiter post_and_await(Honeydew* honeydew, Task& task, size_t worker=0, uint64_t priority=0)
+{
+    return TaskAwaiter{honeydew, std::move(task), worker, priority};
+}
+
+/**
+* Awaitable for a Future. The awaiting coroutine is resumed on any worker once the value is ready.
+*/
+template<typename T>
+struct FutureAwaiter
+{
+    bool await_ready() const noexcept
+    {
+        return future.ready();
+    }
+
+    void await_suspend(std::coroutine_handle<> awaiting)
+    {
+        future.then(detail::make_resume_task(awaiting, 0, 0));
+    }
+
+    auto await_resume() const
+    {
+        return future.get();
+    }
+
+    Future<T> future;
+};
+
+template<typename T>
+FutureAwaiter<T> operator co_await(Future<T> future)
+{
+    return FutureAwaiter<T>{std::move(future)};
+}
+
+}
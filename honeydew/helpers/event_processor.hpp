@@ -6,30 +6,723 @@
 #include <honeydew/honeydew.hpp>
 #include <honeydew/helpers/task_wrapper.hpp>
 #include <honeydew/helpers/pipeline.hpp>
+#include <honeydew/detail/rcu.hpp>
+#include <honeydew/detail/block_pool.hpp>
 
 #include <unordered_map>
+#include <type_traits>
+#include <stdexcept>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <utility>
+#include <exception>
 
 namespace honeydew
 {
 
+/**
+* Identifies a subscriber of an EventProcessor so it can be unsubscribed.
+*/
+typedef uint64_t SubscriptionId;
+
 namespace detail
 {
 
-struct GenericFunction
-{        
-    std::function<void(void* data)> func;
+/**
+* A handler bound into an EventProcessor. The functor is stored inline in the derived
+*  class so dispatching an event costs a single virtual call.
+*  Handlers are reference counted: the EventProcessor holds one reference while the handler
+*  is bound and every posted event holds one until it has run, so a handler can be replaced
+*  or removed while its events are in flight.
+*/
+struct EventHandler
+{
+    EventHandler(size_t worker, uint64_t priority)
+        : worker(worker)
+        , priority(priority)
+        , refs(1)
+    {
+    }
+
+    virtual ~EventHandler() {}
+
+    virtual void operator()(void* data) = 0;
+
+    void acquire()
+    {
+        refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release()
+    {
+        if(refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete this;
+    }
+
     size_t worker;
     uint64_t priority;
+    std::atomic<size_t> refs;
 };
 
+template<typename FunctorType>
+struct EventHandlerImpl : public EventHandler
+{
+    EventHandlerImpl(FunctorType functor, size_t worker, uint64_t priority)
+        : EventHandler(worker, priority)
+        , functor(functor)
+    {
+    }
+
+    virtual void operator()(void* data)
+    {
+        functor(data);
+    }
+
+    FunctorType functor;
+};
+
+template<typename FunctorType>
+EventHandler* make_event_handler(FunctorType functor, size_t worker, uint64_t priority)
+{
+    return new EventHandlerImpl<FunctorType>(functor, worker, priority);
+}
+
+/**
+* Builds the task_t running a handler with the given data. Takes ownership of one reference.
+*/
+inline task_t* make_event_task(EventHandler* handler, void* data)
+{
+    return new task_t([handler, data] () {
+        try
+        {
+            (*handler)(data);
+        }
+        catch(...)
+        {
+            handler->release();
+            throw;
+        }
+        handler->release();
+    }, handler->worker, handler->priority);
 }
 
+/**
+* Gathers a batch of events into one task_t per target worker, priority and lane.
+*  Events in a group run in the order they were added, so events which always land in the
+*  same group (such as those of a single key) keep their order.
+*/
+class EventBatch
+{
+public:
+
+    /**
+    * Adds an event. Takes ownership of one reference of the handler.
+    * @arg handler the handler of the event.
+    * @arg lane separates events of handlers which may run on any worker into independent groups.
+    * @arg data the event data.
+    */
+    void add(EventHandler* handler, size_t lane, void* data)
+    {
+        if(handler->worker != 0)
+            lane = 0;
+
+        size_t g = 0;
+        while(g < groups.size() && (groups[g].worker != handler->worker || groups[g].priority != handler->priority || groups[g].lane != lane))
+            ++g;
+
+        if(g == groups.size())
+        {
+            groups.push_back(Group());
+            groups.back().worker = handler->worker;
+            groups.back().priority = handler->priority;
+            groups.back().lane = lane;
+        }
+        groups[g].events.push_back(std::make_pair(handler, data));
+    }
+
+    /**
+    * Returns the list of group tasks, ready to be posted.
+    */
+    task_t* close()
+    {
+        task_t* result = nullptr;
+        for(size_t g=0; g < groups.size(); ++g)
+        {
+            std::vector<std::pair<EventHandler*, void*>> events;
+            events.swap(groups[g].events);
+            task_t* t = new task_t([events] () { run(events); }, groups[g].worker, groups[g].priority);
+            t->next = result;
+            result = t;
+        }
+        groups.clear();
+        return result;
+    }
+
+private:
+
+    /**
+    * Runs every event of a group. One throwing handler does not keep the rest from running.
+    */
+    static void run(const std::vector<std::pair<EventHandler*, void*>>& events)
+    {
+        std::exception_ptr error = nullptr;
+        for(size_t i=0; i < events.size(); ++i)
+        {
+            try
+            {
+                (*events[i].first)(events[i].second);
+            }
+            catch(...)
+            {
+                if(error == nullptr)
+                    error = std::current_exception();
+            }
+            events[i].first->release();
+        }
+
+        if(error != nullptr)
+            std::rethrow_exception(error);
+    }
+
+    struct Group
+    {
+        size_t worker;
+        uint64_t priority;
+        size_t lane;
+        std::vector<std::pair<EventHandler*, void*>> events;
+    };
+
+    std::vector<Group> groups;
+};
+
+/**
+* The handler of EventProcessor::bind_constructable when construction and handling run on
+*  different workers. The event object is built in a pooled block on the construction worker
+*  and handed to a task on the handler worker, which keeps a reference to this handler rather
+*  than a copy of the functor.
+*/
+template<typename EventDataType, typename CastType, typename FunctorType>
+struct ConstructableHandler : public EventHandler
+{
+    ConstructableHandler(Honeydew* honeydew, FunctorType functor,
+                         size_t handler_worker, uint64_t handler_priority,
+                         size_t construction_worker, uint64_t construction_priority)
+        : EventHandler(construction_worker, construction_priority)
+        , honeydew(honeydew)
+        , functor(functor)
+        , handler_worker(handler_worker)
+        , handler_priority(handler_priority)
+    {
+    }
+
+    virtual void operator()(void* data)
+    {
+        EventDataType* event = BlockPool::create<EventDataType>(static_cast<CastType*>(data));
+        ConstructableHandler* self = this;
+        acquire();
+        try
+        {
+            honeydew->post(new task_t([self, event] () { self->handle(event); }, handler_worker, handler_priority));
+        }
+        catch(...)
+        {
+            // The handler task was rejected (FAIL policy) so it won't clean up after itself.
+            BlockPool::destroy(event);
+            release();
+            throw;
+        }
+    }
+
+    void handle(EventDataType* event)
+    {
+        try
+        {
+            functor(*event);
+        }
+        catch(...)
+        {
+            BlockPool::destroy(event);
+            release();
+            throw;
+        }
+        BlockPool::destroy(event);
+        release();
+    }
+
+    Honeydew* honeydew;
+    FunctorType functor;
+    size_t handler_worker;
+    uint64_t handler_priority;
+};
+
+/**
+* Creates the type erased handler of EventProcessor::bind_constructable.
+*/
+template<typename EventDataType, typename CastType, typename FunctorType>
+EventHandler* make_constructable_handler(Honeydew* honeydew, FunctorType handler,
+                                         size_t handler_worker, uint64_t handler_priority,
+                                         size_t construction_worker, uint64_t construction_priority)
+{
+    if(construction_worker == handler_worker)
+    {
+        return make_event_handler([=] (void* data) {
+            EventDataType event(static_cast<CastType*>(data));
+            handler(event);
+        }, handler_worker, handler_priority);
+    }
+
+    return new ConstructableHandler<EventDataType, CastType, FunctorType>(honeydew, handler,
+        handler_worker, handler_priority, construction_worker, construction_priority);
+}
+
+/**
+* An immutable, reference counted payload shared by every subscriber of a broadcast.
+*/
+struct SharedPayload
+{
+    SharedPayload(size_t refs)
+        : refs(refs)
+    {
+    }
+
+    virtual ~SharedPayload() {}
+
+    virtual void* get() = 0;
+
+    void release()
+    {
+        if(refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            destroy();
+    }
+
+    virtual void destroy() = 0;
+
+    std::atomic<size_t> refs;
+};
+
+template<typename PayloadType>
+struct SharedPayloadImpl : public SharedPayload
+{
+    template<typename... Args>
+    SharedPayloadImpl(size_t refs, Args&&... args)
+        : SharedPayload(refs)
+        , value(std::forward<Args>(args)...)
+    {
+    }
+
+    virtual void* get()
+    {
+        return const_cast<PayloadType*>(&value);
+    }
+
+    virtual void destroy()
+    {
+        BlockPool::destroy(this);
+    }
+
+    const PayloadType value;
+};
+
+/**
+* The subscribers of every key of an EventProcessor. Like the handler table it is copied on
+*  write and read inside an RCU read section, so subscribing never blocks a broadcast.
+*/
+template<typename KeyType>
+class SubscriberTable
+{
+public:
+
+    SubscriberTable()
+        : subscribers(new SubscriberMap())
+        , next_id(1)
+    {
+    }
+
+    ~SubscriberTable()
+    {
+        const SubscriberMap* map = subscribers.load();
+        for(typename SubscriberMap::const_iterator itr = map->begin(); itr != map->end(); ++itr)
+        {
+            for(size_t i=0; i < itr->second.size(); ++i)
+            {
+                itr->second[i].handler->release();
+            }
+        }
+        delete map;
+    }
+
+    uint64_t subscribe(KeyType key_value, EventHandler* handler)
+    {
+        std::unique_lock<std::mutex> lg(writer);
+        const SubscriberMap* old_map = subscribers.load();
+        SubscriberMap* new_map = new SubscriberMap(*old_map);
+
+        uint64_t id = next_id++;
+        (*new_map)[key_value].push_back(Subscriber{id, handler});
+
+        subscribers.store(new_map);
+        rcu.synchronize();
+        delete old_map;
+        return id;
+    }
+
+    bool unsubscribe(KeyType key_value, uint64_t id)
+    {
+        std::unique_lock<std::mutex> lg(writer);
+        const SubscriberMap* old_map = subscribers.load();
+        typename SubscriberMap::const_iterator find_itr = old_map->find(key_value);
+        if(find_itr == old_map->end())
+            return false;
+
+        std::vector<Subscriber> remaining;
+        EventHandler* removed = nullptr;
+        for(size_t i=0; i < find_itr->second.size(); ++i)
+        {
+            if(find_itr->second[i].id == id)
+                removed = find_itr->second[i].handler;
+            else
+                remaining.push_back(find_itr->second[i]);
+        }
+        if(removed == nullptr)
+            return false;
+
+        SubscriberMap* new_map = new SubscriberMap(*old_map);
+        if(remaining.empty())
+            new_map->erase(key_value);
+        else
+            (*new_map)[key_value].swap(remaining);
+
+        subscribers.store(new_map);
+        rcu.synchronize();
+        delete old_map;
+        removed->release();
+        return true;
+    }
+
+    /**
+    * Builds one task per subscriber of the key, all sharing a single payload constructed from args.
+    * @return the list of tasks, or nullptr if the key has no subscribers.
+    */
+    template<typename PayloadType, typename... Args>
+    task_t* broadcast(KeyType key_value, Args&&... args)
+    {
+        std::vector<EventHandler*> handlers;
+
+        size_t token = rcu.read_lock();
+        const SubscriberMap* map = subscribers.load();
+        typename SubscriberMap::const_iterator find_itr = map->find(key_value);
+        if(find_itr != map->end())
+        {
+            handlers.reserve(find_itr->second.size());
+            for(size_t i=0; i < find_itr->second.size(); ++i)
+            {
+                find_itr->second[i].handler->acquire();
+                handlers.push_back(find_itr->second[i].handler);
+            }
+        }
+        rcu.read_unlock(token);
+
+        if(handlers.empty())
+            return nullptr;
+
+        SharedPayload* payload = BlockPool::create<SharedPayloadImpl<PayloadType>>(handlers.size(), std::forward<Args>(args)...);
+
+        task_t* result = nullptr;
+        for(size_t i=handlers.size(); i > 0; --i)
+        {
+            EventHandler* handler = handlers[i - 1];
+            task_t* t = new task_t([handler, payload] () {
+                try
+                {
+                    (*handler)(payload->get());
+                }
+                catch(...)
+                {
+                    handler->release();
+                    payload->release();
+                    throw;
+                }
+                handler->release();
+                payload->release();
+            }, handler->worker, handler->priority);
+            t->next = result;
+            result = t;
+        }
+        return result;
+    }
+
+private:
+    struct Subscriber
+    {
+        uint64_t id;
+        EventHandler* handler;
+    };
+
+    typedef std::unordered_map<KeyType, std::vector<Subscriber>> SubscriberMap;
+
+    std::atomic<const SubscriberMap*> subscribers;
+    uint64_t next_id;
+    RcuDomain rcu;
+    std::mutex writer;
+};
+
+}
+
+/**
+* A class which uses a Honeydew to do dispatching of events whose keys are small integers or enums.
+*  Handlers are kept in a flat array of num_keys entries indexed by the key, so posting an event
+*  does no hashing and builds its task_t directly around the handler without copying it.
+*  Use EventProcessor<KeyType> (num_keys=0) for sparse or non-integral keys.
+*  Handlers can be bound, replaced and unbound while events are being posted. post_event never
+*  blocks; events posted before a rebind still run the handler they were posted with.
+*/
+template<typename KeyType, size_t num_keys=0>
+struct EventProcessor
+{
+    static_assert(std::is_integral<KeyType>::value || std::is_enum<KeyType>::value,
+                  "A dense EventProcessor requires an integral or enum KeyType.");
+
+public:
+
+    /**
+    * Constructs a new EventProcessor which will run on the given Honeydew.
+    */
+    EventProcessor(Honeydew* honeydew)
+        : honeydew(honeydew)
+    {
+        for(size_t i=0; i < num_keys; ++i)
+        {
+            event_handlers[i].store(nullptr);
+        }
+    }
+
+    ~EventProcessor()
+    {
+        for(size_t i=0; i < num_keys; ++i)
+        {
+            detail::EventHandler* handler = event_handlers[i].load();
+            if(handler != nullptr)
+                handler->release();
+        }
+    }
+
+    /**
+    * Deleted copy constructor & copy assignment
+    */
+    EventProcessor(const EventProcessor& other) = delete;
+    EventProcessor& operator=(const EventProcessor& other) = delete;
+
+    /**
+    * Binds an event into this dispatch. See EventProcessor<KeyType>::bind_constructable.
+    *  Throws std::out_of_range if the key is not below num_keys.
+    * This function is thread safe.
+    * @arg key_value the value of the key for this event.
+    * @arg handler a functor taking an EventDataType&.
+    * @arg handler_worker the worker to run the handler upon.
+    * @arg handler_priority the priority of the handler task.
+    * @arg construction_worker the worker used to construct the EventDataType upon.
+    * @arg construction_priority the priority of the construction task.
+    * @return a reference to this object for daisy chains
+    */
+    template<typename EventDataType, typename CastType=typename EventDataType::cast_type, typename FunctorType>
+    EventProcessor& bind_constructable(KeyType key_value, FunctorType handler,
+                                       size_t handler_worker=0, uint64_t handler_priority=0,
+                                       size_t construction_worker=0, uint64_t construction_priority=0)
+    {
+        bind(key_value, detail::make_constructable_handler<EventDataType, CastType>(honeydew, handler,
+            handler_worker, handler_priority, construction_worker, construction_priority));
+        return *this;
+    }
+
+    /**
+    * Binds an event handler which receives the event data cast to CastType*.
+    *  Throws std::out_of_range if the key is not below num_keys.
+    * This function is thread safe.
+    * @arg key_value the value of the event key
+    * @arg functor a functor taking a CastType*.
+    * @arg worker the worker thread to run the casting and handling upon.
+    * @arg priority the priority of the casting and handling task.
+    * @return a reference to this object for daisy chains.
+    */
+    template<typename CastType, typename FunctorType>
+    EventProcessor& bind_castable(KeyType key_value, FunctorType functor, size_t worker=0, uint64_t priority=0)
+    {
+        bind(key_value, detail::make_event_handler([=] (void* data) {
+            functor(static_cast<CastType*>(data));
+        }, worker, priority));
+        return *this;
+    }
+
+    /**
+    * Removes the handler of the given key. Events already posted still run.
+    * This function is thread safe.
+    * @arg key_value the value of the event key.
+    * @return a reference to this object for daisy chains.
+    */
+    EventProcessor& unbind(KeyType key_value)
+    {
+        size_t index = static_cast<size_t>(key_value);
+        if(index < num_keys)
+            replace(index, nullptr);
+        return *this;
+    }
+
+    /**
+    * Posts a new event with the given key_value to the Honeydew.
+    *  Keys which are out of range or unbound are ignored.
+    * This function is thread safe.
+    * @arg key_value the identifying value of the event handler.
+    * @arg data a pointer to the data to be passed into the event handler.
+    * @return a reference to this object for daisy chaining.
+    */
+    EventProcessor& post_event(KeyType key_value, void* data = nullptr)
+    {
+        size_t index = static_cast<size_t>(key_value);
+        if(index >= num_keys)
+            return *this;
+
+        size_t token = rcu.read_lock();
+        detail::EventHandler* handler = event_handlers[index].load();
+        if(handler != nullptr)
+            handler->acquire();
+        rcu.read_unlock(token);
+
+        if(handler != nullptr)
+            honeydew->post(detail::make_event_task(handler, data));
+        return *this;
+    }
+
+    /**
+    * Posts a batch of events with one task per target worker and priority instead of one per event.
+    *  Events of handlers which may run on any worker are spread over the workers by key.
+    *  Events of the same key run in the order they appear in the batch.
+    * This function is thread safe.
+    * @arg begin an iterator to the first event, a std::pair<KeyType, void*> of key and data.
+    * @arg end an iterator past the last event.
+    * @return a reference to this object for daisy chaining.
+    */
+    template<typename IteratorType>
+    EventProcessor& post_events(IteratorType begin, IteratorType end)
+    {
+        detail::EventBatch batch;
+        size_t num_lanes = honeydew->num_workers();
+
+        size_t token = rcu.read_lock();
+        for(IteratorType itr = begin; itr != end; ++itr)
+        {
+            size_t index = static_cast<size_t>(itr->first);
+            if(index >= num_keys)
+                continue;
+
+            detail::EventHandler* handler = event_handlers[index].load();
+            if(handler != nullptr)
+            {
+                handler->acquire();
+                batch.add(handler, index % num_lanes, itr->second);
+            }
+        }
+        rcu.read_unlock(token);
+
+        task_t* tasks = batch.close();
+        if(tasks != nullptr)
+            honeydew->post(tasks);
+        return *this;
+    }
+
+    /**
+    * Adds a subscriber to the broadcasts of the given key. A key may have any number of
+    *  subscribers, each running on its own worker with its own priority.
+    * This function is thread safe.
+    * @arg key_value the value of the event key.
+    * @arg functor a functor taking a const PayloadType&. PayloadType must match the type broadcast on this key.
+    * @arg worker the worker to run the functor upon.
+    * @arg priority the priority of the functor's task.
+    * @return an id which can be given to unsubscribe.
+    */
+    template<typename PayloadType, typename FunctorType>
+    SubscriptionId subscribe(KeyType key_value, FunctorType functor, size_t worker=0, uint64_t priority=0)
+    {
+        return subscribers.subscribe(key_value, detail::make_event_handler([=] (void* data) {
+            functor(*static_cast<const PayloadType*>(data));
+        }, worker, priority));
+    }
+
+    /**
+    * Removes a subscriber. Broadcasts already posted still reach it.
+    * This function is thread safe.
+    * @arg key_value the value of the event key.
+    * @arg id the id returned by subscribe.
+    * @return true if the subscriber was found.
+    */
+    bool unsubscribe(KeyType key_value, SubscriptionId id)
+    {
+        return subscribers.unsubscribe(key_value, id);
+    }
+
+    /**
+    * Delivers a payload to every subscriber of the given key. The payload is moved into a
+    *  single reference counted, immutable object shared by all subscribers, and the tasks
+    *  of all the subscribers are posted together.
+    * This function is thread safe.
+    * @arg key_value the value of the event key.
+    * @arg payload the value to deliver.
+    * @return a reference to this object for daisy chaining.
+    */
+    template<typename PayloadType>
+    EventProcessor& broadcast(KeyType key_value, PayloadType&& payload)
+    {
+        task_t* tasks = subscribers.template broadcast<typename std::decay<PayloadType>::type>(key_value, std::forward<PayloadType>(payload));
+        if(tasks != nullptr)
+            honeydew->post(tasks);
+        return *this;
+    }
+
+private:
+
+    void bind(KeyType key_value, detail::EventHandler* handler)
+    {
+        size_t index = static_cast<size_t>(key_value);
+        if(index >= num_keys)
+        {
+            handler->release();
+            throw std::out_of_range("EventProcessor key is out of range.");
+        }
+        replace(index, handler);
+    }
+
+    /**
+    * Publishes a new handler for the index and drops the table's reference to the old one
+    *  once no post_event can still be acquiring it.
+    */
+    void replace(size_t index, detail::EventHandler* handler)
+    {
+        std::unique_lock<std::mutex> lg(writer);
+        detail::EventHandler* old = event_handlers[index].exchange(handler);
+        if(old != nullptr)
+        {
+            rcu.synchronize();
+            old->release();
+        }
+    }
+
+    Honeydew* honeydew;
+    std::atomic<detail::EventHandler*> event_handlers[num_keys];
+    RcuDomain rcu;
+    std::mutex writer;
+    detail::SubscriberTable<KeyType> subscribers;
+};
+
 /**
 * A class which uses a Honeydew to do dispatching of events.
 *  Different events can be setup to dispatch to different threads as needed.
+*  This is the hashed form used when no num_keys is given. Any hashable KeyType may be used.
+*  The handler table is copied on write and published as an immutable snapshot, so handlers
+*  can be bound, replaced and unbound while events are being posted and post_event never blocks.
+*  Events posted before a rebind still run the handler they were posted with.
 */
 template<typename KeyType>
-struct EventProcessor
+struct EventProcessor<KeyType, 0>
 {
 public:
 
@@ -38,18 +731,37 @@ public:
     */
     EventProcessor(Honeydew* honeydew)
         : honeydew(honeydew)
+        , event_handlers(new HandlerMap())
+    {
+    }
+
+    ~EventProcessor()
     {
+        const HandlerMap* handlers = event_handlers.load();
+        for(typename HandlerMap::const_iterator itr = handlers->begin(); itr != handlers->end(); ++itr)
+        {
+            itr->second->release();
+        }
+        delete handlers;
     }
 
+    /**
+    * Deleted copy constructor & copy assignment
+    */
+    EventProcessor(const EventProcessor& other) = delete;
+    EventProcessor& operator=(const EventProcessor& other) = delete;
+
     /**
     * Binds an event into this dispatch which involves 3 steps:
     *  1. Casting of the input event to CastType*
     *  2. Construction of an EventDataType object from the CastType*.
     *  3. Dispatch of the EventDataType& to a given handler function.
     * If the given handler_worker is different from the given construction_worker the construction
-    *  and handler will happen on different workers with the respective priorities. 
-    * If the given handler_worker is the same as the given construction_worker the construction 
+    *  and handler will happen on different workers with the respective priorities.
+    * If the given handler_worker is the same as the given construction_worker the construction
     *  and handler will happen on the same thread with handler_priority and construction_priority is ignored.
+    * Binding a key which is already bound replaces its handler.
+    * This function is thread safe.
     * @arg key_value the value of the key for this event.
     * @arg handler the function used to handle the EventDataType& object created.
     * @arg handler_worker the worker to run the handler upon.
@@ -59,34 +771,12 @@ public:
     * @return a reference to this object for daisy chains
     */
     template<typename EventDataType, typename CastType=typename EventDataType::cast_type>
-    EventProcessor& bind_constructable(KeyType key_value, std::function<void(EventDataType&)> handler, 
+    EventProcessor& bind_constructable(KeyType key_value, std::function<void(EventDataType&)> handler,
                                        size_t handler_worker=0, uint64_t handler_priority=0,
-                                       size_t construction_worker=0, uint64_t construction_priority=0) 
+                                       size_t construction_worker=0, uint64_t construction_priority=0)
     {
-        Honeydew*& honeydew_copy = honeydew;
-        if(construction_worker == handler_worker)
-        {
-            event_handlers.emplace(
-                key_value,
-                detail::GenericFunction{[=](void* data) {
-                    EventDataType event(static_cast<CastType*>(data));
-                    handler(event);
-                }, handler_worker, handler_priority}
-            );
-        }
-        else
-        {
-            event_handlers.emplace(
-                key_value,
-                detail::GenericFunction{[=](void* data) {
-                    auto event = new EventDataType(static_cast<CastType*>(data));
-                    honeydew_copy->post(Task([=] () {
-                        handler(*event);
-                        delete event;
-                    }, handler_worker, handler_priority));
-                }, construction_worker, construction_priority}
-            );
-        }
+        replace(key_value, detail::make_constructable_handler<EventDataType, CastType>(honeydew, handler,
+            handler_worker, handler_priority, construction_worker, construction_priority));
         return *this;
     }
 
@@ -94,6 +784,8 @@ public:
     * Constructs a new event handler which involves the following steps:
     *  1. Casting of the event data to CastType*.
     *  2. Passing of the casted event data to the given handler.
+    * Binding a key which is already bound replaces its handler.
+    * This function is thread safe.
     * @arg key_value the value of the event key
     * @arg functor the handler function.
     * @arg worker the worker thread to run the casting and handling upon.
@@ -103,33 +795,175 @@ public:
     template<typename CastType>
     EventProcessor& bind_castable(KeyType key_value, std::function<void(CastType*)> functor, size_t worker=0, uint64_t priority=0)
     {
-        event_handlers.emplace(
-            key_value, 
-            detail::GenericFunction{ [=](void* data){ functor(static_cast<CastType*>(data)); }, worker, priority}
-        );
+        replace(key_value, detail::make_event_handler([=] (void* data) {
+            functor(static_cast<CastType*>(data));
+        }, worker, priority));
+        return *this;
+    }
+
+    /**
+    * Removes the handler of the given key. Events already posted still run.
+    * This function is thread safe.
+    * @arg key_value the value of the event key.
+    * @return a reference to this object for daisy chains.
+    */
+    EventProcessor& unbind(KeyType key_value)
+    {
+        replace(key_value, nullptr);
         return *this;
     }
 
     /**
     * Posts a new event with the given key_value to the Honeydew.
+    * This function is thread safe.
     * @arg key_value the identifying value of the event handler.
     * @arg data a pointer to the data to be passed into the event handler.
     * @return a reference to this object for daisy chaining.
     */
     EventProcessor& post_event(KeyType key_value, void* data = nullptr)
     {
-        auto find_itr = event_handlers.find(key_value);
-        if(find_itr != event_handlers.end())
+        detail::EventHandler* handler = nullptr;
+
+        size_t token = rcu.read_lock();
+        const HandlerMap* handlers = event_handlers.load();
+        typename HandlerMap::const_iterator find_itr = handlers->find(key_value);
+        if(find_itr != handlers->end())
+        {
+            handler = find_itr->second;
+            handler->acquire();
+        }
+        rcu.read_unlock(token);
+
+        if(handler != nullptr)
+            honeydew->post(detail::make_event_task(handler, data));
+        return *this;
+    }
+
+    /**
+    * Posts a batch of events with one task per target worker and priority instead of one per event.
+    *  Events of handlers which may run on any worker are spread over the workers by key.
+    *  Events of the same key run in the order they appear in the batch.
+    * This function is thread safe.
+    * @arg begin an iterator to the first event, a std::pair<KeyType, void*> of key and data.
+    * @arg end an iterator past the last event.
+    * @return a reference to this object for daisy chaining.
+    */
+    template<typename IteratorType>
+    EventProcessor& post_events(IteratorType begin, IteratorType end)
+    {
+        detail::EventBatch batch;
+        size_t num_lanes = honeydew->num_workers();
+
+        size_t token = rcu.read_lock();
+        const HandlerMap* handlers = event_handlers.load();
+        for(IteratorType itr = begin; itr != end; ++itr)
         {
-            detail::GenericFunction& func = find_itr->second;
-            honeydew->post(Task([=] () { func.func(data); }, func.worker, func.priority));
+            typename HandlerMap::const_iterator find_itr = handlers->find(itr->first);
+            if(find_itr != handlers->end())
+            {
+                find_itr->second->acquire();
+                batch.add(find_itr->second, hash(itr->first) % num_lanes, itr->second);
+            }
         }
+        rcu.read_unlock(token);
+
+        task_t* tasks = batch.close();
+        if(tasks != nullptr)
+            honeydew->post(tasks);
+        return *this;
+    }
+
+    /**
+    * Adds a subscriber to the broadcasts of the given key. A key may have any number of
+    *  subscribers, each running on its own worker with its own priority.
+    * This function is thread safe.
+    * @arg key_value the value of the event key.
+    * @arg functor a functor taking a const PayloadType&. PayloadType must match the type broadcast on this key.
+    * @arg worker the worker to run the functor upon.
+    * @arg priority the priority of the functor's task.
+    * @return an id which can be given to unsubscribe.
+    */
+    template<typename PayloadType, typename FunctorType>
+    SubscriptionId subscribe(KeyType key_value, FunctorType functor, size_t worker=0, uint64_t priority=0)
+    {
+        return subscribers.subscribe(key_value, detail::make_event_handler([=] (void* data) {
+            functor(*static_cast<const PayloadType*>(data));
+        }, worker, priority));
+    }
+
+    /**
+    * Removes a subscriber. Broadcasts already posted still reach it.
+    * This function is thread safe.
+    * @arg key_value the value of the event key.
+    * @arg id the id returned by subscribe.
+    * @return true if the subscriber was found.
+    */
+    bool unsubscribe(KeyType key_value, SubscriptionId id)
+    {
+        return subscribers.unsubscribe(key_value, id);
+    }
+
+    /**
+    * Delivers a payload to every subscriber of the given key. The payload is moved into a
+    *  single reference counted, immutable object shared by all subscribers, and the tasks
+    *  of all the subscribers are posted together.
+    * This function is thread safe.
+    * @arg key_value the value of the event key.
+    * @arg payload the value to deliver.
+    * @return a reference to this object for daisy chaining.
+    */
+    template<typename PayloadType>
+    EventProcessor& broadcast(KeyType key_value, PayloadType&& payload)
+    {
+        task_t* tasks = subscribers.template broadcast<typename std::decay<PayloadType>::type>(key_value, std::forward<PayloadType>(payload));
+        if(tasks != nullptr)
+            honeydew->post(tasks);
         return *this;
     }
-   
-private: 
+
+private:
+    typedef std::unordered_map<KeyType, detail::EventHandler*> HandlerMap;
+
+    /**
+    * Publishes a copy of the handler table with the key's handler replaced (or removed if
+    *  handler is nullptr), then frees the old table once no post_event can still be reading it.
+    */
+    void replace(KeyType key_value, detail::EventHandler* handler)
+    {
+        std::unique_lock<std::mutex> lg(writer);
+
+        const HandlerMap* old_handlers = event_handlers.load();
+        HandlerMap* new_handlers = new HandlerMap(*old_handlers);
+
+        detail::EventHandler* old = nullptr;
+        typename HandlerMap::iterator find_itr = new_handlers->find(key_value);
+        if(find_itr != new_handlers->end())
+        {
+            old = find_itr->second;
+            if(handler != nullptr)
+                find_itr->second = handler;
+            else
+                new_handlers->erase(find_itr);
+        }
+        else if(handler != nullptr)
+        {
+            new_handlers->emplace(key_value, handler);
+        }
+
+        event_handlers.store(new_handlers);
+        rcu.synchronize();
+
+        delete old_handlers;
+        if(old != nullptr)
+            old->release();
+    }
+
     Honeydew* honeydew;
-    std::unordered_map<KeyType, detail::GenericFunction> event_handlers;
+    std::atomic<const HandlerMap*> event_handlers;
+    std::hash<KeyType> hash;
+    RcuDomain rcu;
+    std::mutex writer;
+    detail::SubscriberTable<KeyType> subscribers;
 };
 
 }
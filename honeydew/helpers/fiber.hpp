@@ -0,0 +1,409 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+#pragma once
+
+#include <honeydew/honeydew.hpp>
+#include <honeydew/helpers/task_wrapper.hpp>
+#include <honeydew/helpers/future.hpp>
+
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace honeydew
+{
+
+namespace detail
+{
+
+/**
+* A cache of fiber stacks. Each stack is mapped with an inaccessible guard page below it so an
+*  overflow faults instead of silently corrupting memory. Stacks are reused since mapping one
+*  costs far more than running a short fiber.
+*/
+class FiberStackPool
+{
+public:
+    static const size_t stack_size = 256 * 1024;
+
+    /**
+    * Returns the lowest usable address of a stack of stack_size bytes.
+    */
+    static void* acquire()
+    {
+        FiberStackPool& p = pool();
+        {
+            std::unique_lock<std::mutex> lg(p.m);
+            if(!p.stacks.empty())
+            {
+                void* stack = p.stacks.back();
+                p.stacks.pop_back();
+                return stack;
+            }
+        }
+
+        size_t guard = page_size();
+        void* mapping = mmap(nullptr, stack_size + guard, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(mapping == MAP_FAILED)
+            throw std::bad_alloc();
+        mprotect(mapping, guard, PROT_NONE);
+        return static_cast<char*>(mapping) + guard;
+    }
+
+    /**
+    * Returns a stack from acquire to the cache (or unmaps it if the cache is full).
+    */
+    static void release(void* stack)
+    {
+        FiberStackPool& p = pool();
+        {
+            std::unique_lock<std::mutex> lg(p.m);
+            if(p.stacks.size() < max_cached)
+            {
+                p.stacks.push_back(stack);
+                return;
+            }
+        }
+
+        size_t guard = page_size();
+        munmap(static_cast<char*>(stack) - guard, stack_size + guard);
+    }
+
+private:
+    static const size_t max_cached = 64;
+
+    static size_t page_size()
+    {
+        static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return size;
+    }
+
+    static FiberStackPool& pool()
+    {
+        // Never destroyed: fibers may still finish while static objects are torn down.
+        static FiberStackPool* p = new FiberStackPool();
+        return *p;
+    }
+
+    std::mutex m;
+    std::vector<void*> stacks;
+};
+
+/**
+* The state of one fiber: its context, its stack and the continuation of the task which
+*  started it. A fiber is only ever running on one thread at a time. When it suspends, the
+*  function deciding how it gets resumed is called after control is back on the worker's
+*  own stack, so the fiber can't be resumed elsewhere while its stack is still in use.
+*/
+class Fiber
+{
+public:
+    Fiber(Honeydew* honeydew, std::function<void()> action, size_t worker, uint64_t priority)
+        : honeydew(honeydew)
+        , action(std::move(action))
+        , worker(worker)
+        , priority(priority)
+        , stack(nullptr)
+        , continuation(nullptr)
+        , join(nullptr)
+        , error(nullptr)
+        , finished(false)
+    {
+    }
+
+    ~Fiber()
+    {
+        if(stack != nullptr)
+            FiberStackPool::release(stack);
+    }
+
+    /**
+    * Starts the fiber from the task_t which runs this function. The continuation and join of
+    *  that task are taken over so they only happen once the fiber has finished.
+    */
+    void start(task_t* task)
+    {
+        continuation = task->continuation;
+        join = task->join;
+        task->continuation = nullptr;
+        task->join = nullptr;
+
+        // Resume on the worker the fiber started on: compiled code may keep the address of a
+        //   thread_local across a call to yield().
+        size_t current = honeydew->current_worker_id();
+        if(current != 0)
+            worker = current;
+
+        stack = FiberStackPool::acquire();
+        getcontext(&context);
+        context.uc_stack.ss_sp = stack;
+        context.uc_stack.ss_size = FiberStackPool::stack_size;
+        context.uc_link = nullptr;
+
+        uintptr_t self = reinterpret_cast<uintptr_t>(this);
+        makecontext(&context, reinterpret_cast<void (*)()>(&Fiber::entry), 2,
+            static_cast<unsigned int>((self >> 16) >> 16), static_cast<unsigned int>(self & 0xffffffff));
+        resume();
+    }
+
+    /**
+    * Switches from the fiber back to the worker. Once off the fiber's stack, park is called
+    *  with the task_t which resumes the fiber.
+    * @arg park posts or attaches the resume task.
+    */
+    void suspend(std::function<void(task_t*)> park)
+    {
+        parked = std::move(park);
+        swapcontext(&context, &caller);
+    }
+
+    /**
+    * Returns the fiber running on the calling thread, or nullptr.
+    */
+    static Fiber*& current()
+    {
+        static thread_local Fiber* fiber = nullptr;
+        return fiber;
+    }
+
+    Honeydew* honeydew;
+
+private:
+    static void entry(unsigned int high, unsigned int low)
+    {
+        uintptr_t self = ((static_cast<uintptr_t>(high) << 16) << 16) | static_cast<uintptr_t>(low);
+        Fiber* fiber = reinterpret_cast<Fiber*>(self);
+        try
+        {
+            fiber->action();
+        }
+        catch(...)
+        {
+            fiber->error = std::current_exception();
+        }
+        fiber->finished = true;
+        setcontext(&fiber->caller);
+    }
+
+    /**
+    * Runs the fiber on the calling thread until it suspends or finishes.
+    */
+    void resume()
+    {
+        Fiber* previous = current();
+        current() = this;
+        swapcontext(&caller, &context);
+        current() = previous;
+
+        if(!finished)
+        {
+            std::function<void(task_t*)> park = std::move(parked);
+            parked = nullptr;
+            task_t* task = new task_t([this] () { resume(); }, worker, priority);
+            task->internal = true;
+            park(task);
+            return;
+        }
+
+        // An empty task carries the continuation so the Honeydew settles the join as usual.
+        if(continuation != nullptr || join != nullptr)
+        {
+            task_t* tail = new task_t([] () {}, worker, priority);
+            tail->continuation = continuation;
+            tail->join = join;
+            tail->internal = true;
+            honeydew->post(tail);
+        }
+
+        std::exception_ptr e = error;
+        delete this;
+        if(e != nullptr)
+            std::rethrow_exception(e);
+    }
+
+    ucontext_t context;
+    ucontext_t caller;
+    std::function<void()> action;
+    std::function<void(task_t*)> parked;
+    size_t worker;
+    uint64_t priority;
+    void* stack;
+    task_t* continuation;
+    join_semaphore_t* join;
+    std::exception_ptr error;
+    bool finished;
+};
+
+}
+
+/**
+* A task which runs on its own pooled stack so it can stop part way through: calling yield()
+*  (or sleep_for / await below) from inside it suspends the fiber, lets its worker run other
+*  tasks and resumes it later as a new task on the same worker with the same priority.
+*  Long computations can give way to more urgent work without being split into pipelines.
+*  Tasks added with then() run once the fiber has finished. The tasks resuming a fiber are
+*  internal, so a bounded Honeydew never rejects or drops a suspended fiber. Stacks are
+*  detail::FiberStackPool::stack_size bytes, so large buffers belong on the heap.
+*  Usage is expected to be like:
+*
+*    HONEYDEW->post(FiberTask(HONEYDEW, [] () {
+*        for(size_t i=0; i < rows; ++i)
+*        {
+*            process(i);
+*            honeydew::yield();
+*        }
+*    }).then(Task(report)));
+*/
+class FiberTask
+{
+public:
+
+    /**
+    * Constructs a new fiber task.
+    * @arg honeydew the Honeydew the fiber is resumed on.
+    * @arg action the function to run on the fiber.
+    * @arg worker the worker to start the fiber upon. Worker=0 means any worker.
+    * @arg priority the priority of the fiber's tasks.
+    */
+    FiberTask(Honeydew* honeydew, std::function<void()> action, size_t worker=0, uint64_t priority=0)
+        : fiber(new detail::Fiber(honeydew, std::move(action), worker, priority))
+        , start(new task_t(nullptr, worker, priority))
+        , has_rest(false)
+    {
+        detail::Fiber* f = fiber;
+        task_t* task = start;
+        start->action = [f, task] () { f->start(task); };
+        start->fusable = false;
+        start->on_discard = [f] () { delete f; };
+    }
+
+    /**
+    * Deleted copy constructor & copy assignment
+    */
+    FiberTask(const FiberTask& other) = delete;
+    FiberTask& operator=(const FiberTask& other) = delete;
+
+    /**
+    * Move constructor.
+    */
+    FiberTask(FiberTask&& other)
+        : fiber(other.fiber)
+        , start(other.start)
+        , rest(std::move(other.rest))
+        , has_rest(other.has_rest)
+    {
+        other.fiber = nullptr;
+        other.start = nullptr;
+        other.has_rest = false;
+    }
+
+    /**
+    * Deletes the fiber if it was never posted.
+    */
+    ~FiberTask()
+    {
+        delete fiber;
+        delete start;
+    }
+
+    /**
+    * Adds a task heirarchy to run once the fiber (and any previously added task) has finished.
+    * @arg next the task to run.
+    * @return a reference to this object for daisy chaining.
+    */
+    FiberTask& then(Task&& next)
+    {
+        if(has_rest)
+        {
+            rest.then(next.close());
+        }
+        else
+        {
+            rest = std::move(next);
+            has_rest = true;
+        }
+        return *this;
+    }
+
+    /**
+    * Returns the task_t* which starts the fiber and then !empties this object!
+    */
+    task_t* close()
+    {
+        if(has_rest)
+            start->continuation = rest.close();
+        task_t* result = start;
+        fiber = nullptr;
+        start = nullptr;
+        has_rest = false;
+        return result;
+    }
+
+private:
+    detail::Fiber* fiber;
+    task_t* start;
+    Task rest;
+    bool has_rest;
+};
+
+/**
+* Suspends the calling fiber and queues it behind the tasks already waiting on its worker.
+*  Does nothing when the calling thread is not running a fiber.
+*/
+inline void yield()
+{
+    detail::Fiber* fiber = detail::Fiber::current();
+    if(fiber == nullptr)
+        return;
+
+    Honeydew* honeydew = fiber->honeydew;
+    fiber->suspend([honeydew] (task_t* resume) { honeydew->post(resume); });
+}
+
+/**
+* Suspends the calling fiber for the given duration without holding up its worker.
+*  A thread which is not running a fiber sleeps.
+* @arg delay a std::chrono duration to wait.
+*/
+template<typename Rep, typename Period>
+void sleep_for(std::chrono::duration<Rep, Period> delay)
+{
+    detail::Fiber* fiber = detail::Fiber::current();
+    if(fiber == nullptr)
+    {
+        std::this_thread::sleep_for(delay);
+        return;
+    }
+
+    Honeydew* honeydew = fiber->honeydew;
+    fiber->suspend([honeydew, delay] (task_t* resume) { honeydew->post_after(resume, delay); });
+}
+
+/**
+* Returns the value of the future. A fiber is suspended until the value is available instead
+*  of blocking its worker, other threads wait as in Future::get.
+* @arg future the future to wait for.
+*/
+template<typename T>
+typename detail::FutureState<T>::get_type await(const Future<T>& future)
+{
+    detail::Fiber* fiber = detail::Fiber::current();
+    if(fiber != nullptr && !future.ready())
+    {
+        Future<T> waiting = future;
+        fiber->suspend([waiting] (task_t* resume) mutable { waiting.then(resume); });
+    }
+    return future.get();
+}
+
+}
@@ -0,0 +1,601 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+#pragma once
+
+#include <honeydew/honeydew.hpp>
+#include <honeydew/detail/wait_flag.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace honeydew
+{
+
+template<typename T> class Future;
+
+namespace detail
+{
+
+/**
+* The part of a future's shared state which does not depend on the value type.
+*  Completion is lock-free: a flag is set and any attached continuations are posted.
+*/
+class FutureStateBase
+{
+public:
+
+    /**
+    * Creates a new shared state with a single reference.
+    * @arg honeydew the Honeydew continuations are posted to.
+    */
+    FutureStateBase(Honeydew* honeydew)
+        : honeydew(honeydew)
+        , error(nullptr)
+        , refs(1)
+        , continuations(nullptr)
+    {
+    }
+
+    virtual ~FutureStateBase()
+    {
+    }
+
+    void retain()
+    {
+        refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release()
+    {
+        if(refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete this;
+    }
+
+    /**
+    * Returns true if the value (or an exception) has been set.
+    */
+    bool ready() const
+    {
+        return flag.is_set();
+    }
+
+    /**
+    * Blocks until the value (or an exception) has been set. Workers keep running their own
+    *  tasks while waiting, other threads spin briefly first since most tasks complete quickly.
+    */
+    void wait()
+    {
+        flag.wait(honeydew, spin_count);
+    }
+
+    /**
+    * Attaches a task to be posted once this state is complete. If the state is
+    *  already complete the task is posted immediately.
+    * @arg task the task to post.
+    */
+    void attach(task_t* task)
+    {
+        task_t* head = continuations.load(std::memory_order_acquire);
+        do
+        {
+            if(head == completed_marker())
+            {
+                honeydew->post(task);
+                return;
+            }
+            task->next = head;
+        } while(!continuations.compare_exchange_weak(head, task, std::memory_order_acq_rel, std::memory_order_acquire));
+    }
+
+    /**
+    * Rethrows the stored exception, if any.
+    */
+    void rethrow_if_error() const
+    {
+        if(error != nullptr)
+            std::rethrow_exception(error);
+    }
+
+    Honeydew* honeydew;
+    std::exception_ptr error;
+
+protected:
+
+    /**
+    * Marks this state as complete, wakes any sleeping waiters and posts all
+    *  attached continuations in a single post.
+    */
+    void complete()
+    {
+        flag.set();
+
+        task_t* head = continuations.exchange(completed_marker(), std::memory_order_acq_rel);
+        if(head != nullptr)
+            honeydew->post(head);
+    }
+
+private:
+    static const size_t spin_count = 64;
+
+    task_t* completed_marker()
+    {
+        return reinterpret_cast<task_t*>(this);
+    }
+
+    std::atomic<unsigned int> refs;
+    std::atomic<task_t*> continuations;
+    WaitFlag flag;
+};
+
+/**
+* Shared state holding a T value in place. The value is never default constructed.
+*/
+template<typename T>
+class FutureState : public FutureStateBase
+{
+public:
+    typedef const T& get_type;
+
+    FutureState(Honeydew* honeydew)
+        : FutureStateBase(honeydew)
+        , has_value(false)
+    {
+    }
+
+    ~FutureState()
+    {
+        if(has_value)
+            reinterpret_cast<T*>(&storage)->~T();
+    }
+
+    /**
+    * Stores the result of calling functor (or the exception it throws) and completes.
+    */
+    template<typename FunctorType>
+    void fulfill(FunctorType& functor)
+    {
+        try
+        {
+            new (&storage) T(functor());
+            has_value = true;
+        }
+        catch(...)
+        {
+            error = std::current_exception();
+        }
+        complete();
+    }
+
+    /**
+    * Stores the given exception and completes.
+    */
+    void fail(std::exception_ptr e)
+    {
+        error = e;
+        complete();
+    }
+
+    get_type get() const
+    {
+        rethrow_if_error();
+        return *reinterpret_cast<const T*>(&storage);
+    }
+
+private:
+    typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type storage;
+    bool has_value;
+};
+
+template<>
+class FutureState<void> : public FutureStateBase
+{
+public:
+    typedef void get_type;
+
+    FutureState(Honeydew* honeydew)
+        : FutureStateBase(honeydew)
+    {
+    }
+
+    template<typename FunctorType>
+    void fulfill(FunctorType& functor)
+    {
+        try
+        {
+            functor();
+        }
+        catch(...)
+        {
+            error = std::current_exception();
+        }
+        complete();
+    }
+
+    void fail(std::exception_ptr e)
+    {
+        error = e;
+        complete();
+    }
+
+    get_type get() const
+    {
+        rethrow_if_error();
+    }
+};
+
+/**
+* Shared state which also owns the functor producing its value. The task_t posted
+*  for it only captures a pointer to this state, so std::function stores the action
+*  inline and the functor, value and completion flags share a single allocation.
+*/
+template<typename T, typename FunctorType>
+class FutureTask : public FutureState<T>
+{
+public:
+    FutureTask(Honeydew* honeydew, FunctorType&& functor)
+        : FutureState<T>(honeydew)
+        , functor(std::move(functor))
+    {
+    }
+
+    /**
+    * Creates the task_t which runs the functor. The task holds its own reference.
+    * @arg worker the worker to run the functor upon.
+    * @arg priority the priority of the task.
+    */
+    task_t* make_task(size_t worker, uint64_t priority)
+    {
+        this->retain();
+        FutureTask* self = this;
+        return new task_t([self] () { self->run(); }, worker, priority);
+    }
+
+private:
+    void run()
+    {
+        this->fulfill(functor);
+        this->release();
+    }
+
+    FunctorType functor;
+};
+
+/**
+* The type of action accepted by Future<T>::then. (void can not be used as a parameter type)
+*/
+template<typename T, typename U>
+struct ThenAction
+{
+    typedef std::function<U(T)> type;
+};
+
+template<typename U>
+struct ThenAction<void, U>
+{
+    typedef std::function<U()> type;
+};
+
+/**
+* Placeholder for the result type of Future::then when it is deduced from the action.
+*/
+struct DeducedResult {};
+
+/**
+* The result type of an action given to Future::then: U if it was given explicitly,
+*  otherwise what the action returns when called with the value.
+*/
+template<typename T, typename U, typename FunctorType>
+struct ThenResult
+{
+    typedef U type;
+};
+
+template<typename T, typename FunctorType>
+struct ThenResult<T, DeducedResult, FunctorType>
+{
+    typedef typename std::decay<typename std::result_of<FunctorType(T)>::type>::type type;
+};
+
+template<typename FunctorType>
+struct ThenResult<void, DeducedResult, FunctorType>
+{
+    typedef typename std::decay<typename std::result_of<FunctorType()>::type>::type type;
+};
+
+/**
+* Functor used by Future::then which calls the action with the value of the source state.
+*  The source state is released when the functor is destroyed.
+*/
+template<typename T, typename U>
+struct ThenFunctor
+{
+    ThenFunctor(FutureState<T>* source, std::function<U(T)> action)
+        : source(source)
+        , action(std::move(action))
+    {
+        source->retain();
+    }
+
+    ThenFunctor(ThenFunctor&& other)
+        : source(other.source)
+        , action(std::move(other.action))
+    {
+        other.source = nullptr;
+    }
+
+    ~ThenFunctor()
+    {
+        if(source != nullptr)
+            source->release();
+    }
+
+    U operator() ()
+    {
+        return action(source->get());
+    }
+
+    FutureState<T>* source;
+    std::function<U(T)> action;
+};
+
+template<typename U>
+struct ThenFunctor<void, U>
+{
+    ThenFunctor(FutureState<void>* source, std::function<U()> action)
+        : source(source)
+        , action(std::move(action))
+    {
+        source->retain();
+    }
+
+    ThenFunctor(ThenFunctor&& other)
+        : source(other.source)
+        , action(std::move(other.action))
+    {
+        other.source = nullptr;
+    }
+
+    ~ThenFunctor()
+    {
+        if(source != nullptr)
+            source->release();
+    }
+
+    U operator() ()
+    {
+        source->get();
+        return action();
+    }
+
+    FutureState<void>* source;
+    std::function<U()> action;
+};
+
+}
+
+/**
+* A handle to a value which will be produced by a task posted to a Honeydew.
+*  Futures may be copied; every copy refers to the same shared state.
+*/
+template<typename T>
+class Future
+{
+public:
+
+    /**
+    * Constructs an empty future which is not associated with any state.
+    */
+    Future()
+        : state(nullptr)
+    {
+    }
+
+    /**
+    * Constructs a future which adopts a reference to the given state.
+    *  This constructor is intended to be used by the helpers in this file ONLY!
+    */
+    explicit Future(detail::FutureState<T>* state)
+        : state(state)
+    {
+    }
+
+    Future(const Future& other)
+        : state(other.state)
+    {
+        if(state != nullptr)
+            state->retain();
+    }
+
+    Future(Future&& other)
+        : state(other.state)
+    {
+        other.state = nullptr;
+    }
+
+    Future& operator=(Future other)
+    {
+        std::swap(state, other.state);
+        return *this;
+    }
+
+    ~Future()
+    {
+        if(state != nullptr)
+            state->release();
+    }
+
+    /**
+    * Returns true if this future is associated with a state.
+    */
+    bool valid() const
+    {
+        return state != nullptr;
+    }
+
+    /**
+    * Returns true if the value (or an exception) is available. Never blocks.
+    */
+    bool ready() const
+    {
+        return state->ready();
+    }
+
+    /**
+    * Blocks the calling thread until the value (or an exception) is available.
+    */
+    void wait() const
+    {
+        state->wait();
+    }
+
+    /**
+    * Blocks until the value is available and returns it. If the task threw an exception
+    *  it is rethrown here.
+    * @return a reference to the value which remains valid while this future exists.
+    */
+    typename detail::FutureState<T>::get_type get() const
+    {
+        state->wait();
+        return state->get();
+    }
+
+    /**
+    * Attaches an action to be posted once the value is available. The action receives the
+    *  value and its result is made available through the returned future. If this future
+    *  holds an exception the action is skipped and the exception is forwarded.
+    *  The result type is deduced from the action, or may be given explicitly as in then<long>(...).
+    * @arg action the function to run with the value.
+    * @arg worker the worker to run the action upon.
+    * @arg priority the priority of the action.
+    * @return a future for the result of the action.
+    */
+    template<typename U=detail::DeducedResult, typename ActionType>
+    Future<typename detail::ThenResult<T, U, ActionType>::type> then(ActionType action, size_t worker=0, uint64_t priority=0)
+    {
+        typedef typename detail::ThenResult<T, U, ActionType>::type ResultType;
+        typedef detail::ThenFunctor<T, ResultType> FunctorType;
+        typename detail::ThenAction<T, ResultType>::type wrapped(std::move(action));
+        detail::FutureTask<ResultType, FunctorType>* next = new detail::FutureTask<ResultType, FunctorType>(state->honeydew, FunctorType(state, std::move(wrapped)));
+        state->attach(next->make_task(worker, priority));
+        return Future<ResultType>(next);
+    }
+
+    /**
+    * Posts the given task once the value is available (immediately if it already is).
+    * @arg task the root of a task_t* heirarchy to post.
+    */
+    void then(task_t* task)
+    {
+        state->attach(task);
+    }
+
+private:
+    detail::FutureState<T>* state;
+};
+
+/**
+* The producing side of a Future for values which are not the result of a single task.
+*/
+template<typename T>
+class Promise
+{
+public:
+
+    /**
+    * Creates a new promise.
+    * @arg honeydew the Honeydew continuations of the future are posted to.
+    */
+    Promise(Honeydew* honeydew)
+        : state(new detail::FutureState<T>(honeydew))
+        , satisfied(false)
+    {
+    }
+
+    Promise(const Promise& other) = delete;
+    Promise& operator=(const Promise& other) = delete;
+
+    Promise(Promise&& other)
+        : state(other.state)
+        , satisfied(other.satisfied)
+    {
+        other.state = nullptr;
+    }
+
+    /**
+    * Releases the shared state. If no value was set, waiters receive a std::runtime_error.
+    */
+    ~Promise()
+    {
+        if(state != nullptr)
+        {
+            if(!satisfied)
+                state->fail(std::make_exception_ptr(std::runtime_error("Promise destroyed without a value")));
+            state->release();
+        }
+    }
+
+    /**
+    * Returns a future which shares this promise's state.
+    */
+    Future<T> get_future()
+    {
+        state->retain();
+        return Future<T>(state);
+    }
+
+    /**
+    * Constructs the value from the given arguments and completes the future.
+    *  Throws std::logic_error if the promise was already satisfied.
+    */
+    template<typename... Args>
+    void set_value(Args&&... args)
+    {
+        auto functor = [&] () { return T(std::forward<Args>(args)...); };
+        satisfy();
+        state->fulfill(functor);
+    }
+
+    /**
+    * Completes the future with the given exception.
+    *  Throws std::logic_error if the promise was already satisfied.
+    */
+    void set_exception(std::exception_ptr e)
+    {
+        satisfy();
+        state->fail(e);
+    }
+
+private:
+    void satisfy()
+    {
+        if(satisfied)
+            throw std::logic_error("Promise already satisfied");
+        satisfied = true;
+    }
+
+    detail::FutureState<T>* state;
+    bool satisfied;
+};
+
+/**
+* Posts the given functor to the Honeydew and returns a future for its result.
+* This function is thread safe.
+* @arg honeydew the Honeydew to post to.
+* @arg functor the nullary function to run.
+* @arg worker the worker to run the functor upon. Worker=0 means any worker.
+* @arg priority the priority of the task.
+* @return a future for the value returned by the functor.
+*/
+template<typename FunctorType>
+auto post_future(Honeydew* honeydew, FunctorType functor, size_t worker=0, uint64_t priority=0) -> Future<decltype(functor())>
+{
+    typedef decltype(functor()) ResultType;
+    detail::FutureTask<ResultType, FunctorType>* state = new detail::FutureTask<ResultType, FunctorType>(honeydew, std::move(functor));
+    honeydew->post(state->make_task(worker, priority));
+    return Future<ResultType>(state);
+}
+
+}
@@ -0,0 +1,597 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+#pragma once
+
+#include <honeydew/honeydew.hpp>
+#include <honeydew/helpers/task_wrapper.hpp>
+
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace honeydew
+{
+
+class LoopTask;
+class SwitchTask;
+
+namespace detail
+{
+
+/**
+* A part of a reusable task graph. Its tasks are persistent: they are built once, reposted
+*  every time the block runs and only freed when the block is deleted, which must not happen
+*  while any of them is queued or running.
+*/
+struct ReusableBlock
+{
+    virtual ~ReusableBlock() {}
+
+    /**
+    * Returns the task to post to run the block.
+    */
+    virtual task_t* entry() = 0;
+
+    /**
+    * Sets the task posted once the block has finished.
+    */
+    virtual void attach(task_t* next) = 0;
+
+    /**
+    * Sets the discard hook of every task of the block, called if one is dropped instead of run.
+    */
+    virtual void set_discard(const std::function<void()>& hook) = 0;
+
+    static task_t* make_persistent(std::function<void()> action, size_t worker, uint64_t priority)
+    {
+        task_t* task = new task_t(action, worker, priority);
+        task->persistent = true;
+        return task;
+    }
+
+    /**
+    * Frees a persistent task. Its continuation belongs to another block.
+    */
+    static void free_persistent(task_t* task)
+    {
+        task->continuation = nullptr;
+        delete task;
+    }
+};
+
+/**
+* A single stage.
+*/
+struct StageBlock : public ReusableBlock
+{
+    StageBlock(std::function<void()> action, size_t worker, uint64_t priority)
+        : task(make_persistent(action, worker, priority))
+    {
+    }
+
+    virtual ~StageBlock()
+    {
+        free_persistent(task);
+    }
+
+    virtual task_t* entry()
+    {
+        return task;
+    }
+
+    virtual void attach(task_t* next)
+    {
+        task->continuation = next;
+    }
+
+    virtual void set_discard(const std::function<void()>& hook)
+    {
+        task->on_discard = hook;
+    }
+
+    task_t* task;
+};
+
+/**
+* Blocks which run one after the other.
+*/
+struct ChainBlock : public ReusableBlock
+{
+    virtual ~ChainBlock()
+    {
+        for(size_t i=0; i < blocks.size(); ++i)
+        {
+            delete blocks[i];
+        }
+    }
+
+    void add(ReusableBlock* block)
+    {
+        if(!blocks.empty())
+            blocks.back()->attach(block->entry());
+        blocks.push_back(block);
+    }
+
+    bool empty() const
+    {
+        return blocks.empty();
+    }
+
+    /**
+    * Returns the first task of the chain, or nullptr if it is empty.
+    */
+    virtual task_t* entry()
+    {
+        return blocks.empty() ? nullptr : blocks.front()->entry();
+    }
+
+    virtual void attach(task_t* next)
+    {
+        if(!blocks.empty())
+            blocks.back()->attach(next);
+    }
+
+    virtual void set_discard(const std::function<void()>& hook)
+    {
+        for(size_t i=0; i < blocks.size(); ++i)
+        {
+            blocks[i]->set_discard(hook);
+        }
+    }
+
+    std::vector<ReusableBlock*> blocks;
+};
+
+/**
+* Runs its body while (or until) a condition holds. The condition task picks its own
+*  continuation each time it runs: the body's first task, or the exit.
+*/
+struct LoopBlock : public ReusableBlock
+{
+    LoopBlock(std::function<bool()> condition, bool test_first, bool until, size_t worker, uint64_t priority)
+        : condition(condition)
+        , test_first(test_first)
+        , until(until)
+        , priority(priority)
+        , exit(nullptr)
+    {
+        LoopBlock* self = this;
+        check = make_persistent([self] () { self->run_check(); }, worker, priority);
+    }
+
+    virtual ~LoopBlock()
+    {
+        free_persistent(check);
+    }
+
+    virtual task_t* entry()
+    {
+        if(test_first || body.empty())
+            return check;
+        return body.entry();
+    }
+
+    virtual void attach(task_t* next)
+    {
+        exit = next;
+    }
+
+    virtual void set_discard(const std::function<void()>& hook)
+    {
+        check->on_discard = hook;
+        body.set_discard(hook);
+    }
+
+    void add(ReusableBlock* block)
+    {
+        body.add(block);
+        body.attach(check);
+    }
+
+    void run_check()
+    {
+        // A throwing condition ends the loop.
+        check->continuation = exit;
+        if(condition() != until)
+            check->continuation = body.empty() ? check : body.entry();
+    }
+
+    std::function<bool()> condition;
+    bool test_first;
+    bool until;
+    uint64_t priority;
+    task_t* check;
+    task_t* exit;
+    ChainBlock body;
+};
+
+/**
+* Runs the case selected by a function, or the default case if no case matches.
+*  The selector task picks its own continuation each time it runs.
+*/
+struct SwitchBlock : public ReusableBlock
+{
+    SwitchBlock(std::function<size_t()> selector, size_t worker, uint64_t priority)
+        : selector(selector)
+        , priority(priority)
+        , exit(nullptr)
+    {
+        SwitchBlock* self = this;
+        select = make_persistent([self] () { self->run_select(); }, worker, priority);
+    }
+
+    virtual ~SwitchBlock()
+    {
+        for(auto it = cases.begin(); it != cases.end(); ++it)
+        {
+            delete it->second;
+        }
+        free_persistent(select);
+    }
+
+    virtual task_t* entry()
+    {
+        return select;
+    }
+
+    virtual void attach(task_t* next)
+    {
+        exit = next;
+        for(auto it = cases.begin(); it != cases.end(); ++it)
+        {
+            it->second->attach(next);
+        }
+        otherwise.attach(next);
+    }
+
+    virtual void set_discard(const std::function<void()>& hook)
+    {
+        select->on_discard = hook;
+        for(auto it = cases.begin(); it != cases.end(); ++it)
+        {
+            it->second->set_discard(hook);
+        }
+        otherwise.set_discard(hook);
+    }
+
+    /**
+    * Returns the chain of the given case, creating it if needed.
+    */
+    ChainBlock* at(size_t value)
+    {
+        ChainBlock*& chain = cases[value];
+        if(chain == nullptr)
+            chain = new ChainBlock();
+        return chain;
+    }
+
+    void run_select()
+    {
+        // A throwing selector skips every case.
+        select->continuation = exit;
+
+        ChainBlock* chain = &otherwise;
+        auto it = cases.find(selector());
+        if(it != cases.end())
+            chain = it->second;
+
+        if(!chain->empty())
+            select->continuation = chain->entry();
+    }
+
+    std::function<size_t()> selector;
+    uint64_t priority;
+    task_t* select;
+    task_t* exit;
+    std::unordered_map<size_t, ChainBlock*> cases;
+    ChainBlock otherwise;
+};
+
+/**
+* Deletes a closed construct once it has finished and then posts what follows it.
+*  If one of its tasks is dropped instead (see Honeydew::OverflowPolicy) the construct ends there:
+*  it is deleted along with what follows it, as the continuation of a dropped task would be.
+*/
+inline task_t* close_block(ReusableBlock* block, Task& after, size_t worker, uint64_t priority)
+{
+    task_t* cleanup = new task_t([block] () { delete block; }, worker, priority);
+    cleanup->continuation = after.close();
+    cleanup->on_discard = [block] () { delete block; };
+    block->attach(cleanup);
+
+    // At most one task of the construct is queued at a time, so the one dropped is the only one left.
+    block->set_discard([block, cleanup] () {
+        delete cleanup;
+        delete block;
+    });
+    return block->entry();
+}
+
+}
+
+/**
+* A loop whose condition and body are built once and re-run on every iteration.
+*  The body is a chain of stages (and nested loops or switches) which run one after the other.
+*  Its tasks are persistent: posting an iteration neither allocates nor frees anything, unlike
+*  building a new ConditionalTask per iteration. Everything is freed once the loop ends.
+*  If a stage throws the loop carries on, and if the condition throws the loop ends.
+*  If a bounded Honeydew drops one of its tasks, the loop is freed without running after().
+*
+* Example (retries until a connection is made, then sends):
+*   honeydew->post(LoopTask([&] () { return !try_connect(); }, LoopTask::WHILE, IO_WORKER)
+*       .then([&] () { ++attempts; })
+*       .after(Task([&] () { send(); })));
+*/
+class LoopTask
+{
+public:
+
+    enum Mode
+    {
+        WHILE,          // The condition is checked before each iteration; the loop runs while it is true.
+        REPEAT_UNTIL    // The body runs first; the loop repeats until the condition is true.
+    };
+
+    /**
+    * Creates a new loop.
+    * @arg condition the function deciding whether the loop carries on.
+    * @arg mode when the condition is checked and what it means.
+    * @arg worker the worker to check the condition on.
+    * @arg priority the priority of the condition. Body stage priorities are relative to it.
+    */
+    LoopTask(std::function<bool()> condition, Mode mode=WHILE, size_t worker=0, uint64_t priority=0)
+        : block(new detail::LoopBlock(condition, mode == WHILE, mode == REPEAT_UNTIL, worker, priority))
+        , worker(worker)
+        , priority(priority)
+    {
+    }
+
+    LoopTask(LoopTask&& other)
+        : block(other.block)
+        , after_task(std::move(other.after_task))
+        , worker(other.worker)
+        , priority(other.priority)
+    {
+        other.block = nullptr;
+    }
+
+    /**
+    * Deleted copy constructor & copy assignment
+    */
+    LoopTask(const LoopTask& other) = delete;
+    LoopTask& operator=(const LoopTask& other) = delete;
+
+    ~LoopTask()
+    {
+        delete block;
+    }
+
+    /**
+    * Appends a stage to the body.
+    * @arg action the function to run.
+    * @arg worker the worker to run the stage on.
+    * @arg priority the priority of the stage, relative to the loop's.
+    * @return a reference to this for daisy chaining.
+    */
+    LoopTask& then(std::function<void()> action, size_t worker=0, uint64_t priority=0)
+    {
+        block->add(new detail::StageBlock(action, worker, block->priority + priority));
+        return *this;
+    }
+
+    /**
+    * Appends a nested loop to the body. It is re-run, not rebuilt, on every iteration.
+    * @return a reference to this for daisy chaining.
+    */
+    LoopTask& then(LoopTask&& other);
+
+    /**
+    * Appends a switch to the body. It is re-run, not rebuilt, on every iteration.
+    * @return a reference to this for daisy chaining.
+    */
+    LoopTask& then(SwitchTask&& other);
+
+    /**
+    * Sets the task posted once the loop has ended.
+    * @arg other the Task wrapper to steal internals from.
+    * @return a reference to this for daisy chaining.
+    */
+    LoopTask& after(Task&& other)
+    {
+        after_task = std::forward<Task>(other);
+        return *this;
+    }
+
+    /**
+    * Closes this loop and returns the task_t* which starts it.
+    * @return the task_t* generated and ready to be pushed to a Honeydew.
+    */
+    task_t* close()
+    {
+        detail::LoopBlock* closed = release();
+        return detail::close_block(closed, after_task, worker, priority);
+    }
+
+private:
+    friend class SwitchTask;
+
+    detail::LoopBlock* release()
+    {
+        detail::LoopBlock* result = block;
+        block = nullptr;
+        return result;
+    }
+
+    detail::LoopBlock* block;
+    Task after_task;
+    size_t worker;
+    uint64_t priority;
+};
+
+/**
+* A multi-way branch whose cases are built once. Posting it runs the case selected by the
+*  selector, or the default case if no case matches; the cases which aren't taken are kept,
+*  not deleted, so a switch nested in a LoopTask costs no allocation per iteration.
+*  If the selector throws no case runs. If a bounded Honeydew drops one of its tasks, the switch
+*  is freed without running after().
+*
+* Example:
+*   honeydew->post(SwitchTask([&] () { return state; })
+*       .on(CONNECTING).then(connect)
+*       .on(READY).then(send).then(flush)
+*       .otherwise().then(reset));
+*/
+class SwitchTask
+{
+public:
+
+    /**
+    * Creates a new switch.
+    * @arg selector the function returning the value of the case to run.
+    * @arg worker the worker to run the selector on.
+    * @arg priority the priority of the selector. Case stage priorities are relative to it.
+    */
+    SwitchTask(std::function<size_t()> selector, size_t worker=0, uint64_t priority=0)
+        : block(new detail::SwitchBlock(selector, worker, priority))
+        , current(nullptr)
+        , worker(worker)
+        , priority(priority)
+    {
+    }
+
+    SwitchTask(SwitchTask&& other)
+        : block(other.block)
+        , current(other.current)
+        , after_task(std::move(other.after_task))
+        , worker(other.worker)
+        , priority(other.priority)
+    {
+        other.block = nullptr;
+        other.current = nullptr;
+    }
+
+    /**
+    * Deleted copy constructor & copy assignment
+    */
+    SwitchTask(const SwitchTask& other) = delete;
+    SwitchTask& operator=(const SwitchTask& other) = delete;
+
+    ~SwitchTask()
+    {
+        delete block;
+    }
+
+    /**
+    * Starts (or continues) the case for the given value. Following calls to then() add to it.
+    * @return a reference to this for daisy chaining.
+    */
+    SwitchTask& on(size_t value)
+    {
+        current = block->at(value);
+        return *this;
+    }
+
+    /**
+    * Starts (or continues) the default case. Following calls to then() add to it.
+    * @return a reference to this for daisy chaining.
+    */
+    SwitchTask& otherwise()
+    {
+        current = &block->otherwise;
+        return *this;
+    }
+
+    /**
+    * Appends a stage to the current case. Throws std::runtime_error if no case was started.
+    * @arg action the function to run.
+    * @arg worker the worker to run the stage on.
+    * @arg priority the priority of the stage, relative to the switch's.
+    * @return a reference to this for daisy chaining.
+    */
+    SwitchTask& then(std::function<void()> action, size_t worker=0, uint64_t priority=0)
+    {
+        return add(new detail::StageBlock(action, worker, block->priority + priority));
+    }
+
+    /**
+    * Appends a nested loop to the current case.
+    * @return a reference to this for daisy chaining.
+    */
+    SwitchTask& then(LoopTask&& other)
+    {
+        return add(other.release());
+    }
+
+    /**
+    * Appends a nested switch to the current case.
+    * @return a reference to this for daisy chaining.
+    */
+    SwitchTask& then(SwitchTask&& other)
+    {
+        return add(other.release());
+    }
+
+    /**
+    * Sets the task posted once the selected case has finished.
+    * @arg other the Task wrapper to steal internals from.
+    * @return a reference to this for daisy chaining.
+    */
+    SwitchTask& after(Task&& other)
+    {
+        after_task = std::forward<Task>(other);
+        return *this;
+    }
+
+    /**
+    * Closes this switch and returns the task_t* which starts it.
+    * @return the task_t* generated and ready to be pushed to a Honeydew.
+    */
+    task_t* close()
+    {
+        detail::SwitchBlock* closed = release();
+        return detail::close_block(closed, after_task, worker, priority);
+    }
+
+private:
+    friend class LoopTask;
+
+    SwitchTask& add(detail::ReusableBlock* added)
+    {
+        if(current == nullptr)
+        {
+            delete added;
+            throw std::runtime_error("SwitchTask::then called before on() or otherwise().");
+        }
+        current->add(added);
+        return *this;
+    }
+
+    detail::SwitchBlock* release()
+    {
+        detail::SwitchBlock* result = block;
+        block = nullptr;
+        current = nullptr;
+        return result;
+    }
+
+    detail::SwitchBlock* block;
+    detail::ChainBlock* current;
+    Task after_task;
+    size_t worker;
+    uint64_t priority;
+};
+
+inline LoopTask& LoopTask::then(LoopTask&& other)
+{
+    block->add(other.release());
+    return *this;
+}
+
+inline LoopTask& LoopTask::then(SwitchTask&& other)
+{
+    block->add(other.release());
+    return *this;
+}
+
+}
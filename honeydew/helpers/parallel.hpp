@@ -0,0 +1,428 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+#pragma once
+
+#include <honeydew/honeydew.hpp>
+#include <honeydew/helpers/task_wrapper.hpp>
+#include <honeydew/detail/join_semaphore.hpp>
+#include <honeydew/detail/wait_flag.hpp>
+
+#include <exception>
+#include <mutex>
+#include <vector>
+
+namespace honeydew
+{
+
+/**
+* A half open range [begin, end) of indices used by the data-parallel helpers.
+*/
+template<typename IndexType>
+struct Range
+{
+    /**
+    * Typedef that allows other classes to extract our template parameter.
+    */
+    typedef IndexType index_type;
+
+    Range(IndexType begin, IndexType end)
+        : begin(begin)
+        , end(end)
+    {
+    }
+
+    /**
+    * Returns the number of indices in this range. An inverted range (begin > end) is empty.
+    */
+    IndexType size() const
+    {
+        return end > begin ? end - begin : 0;
+    }
+
+    /**
+    * Splits this range in half. This range keeps the lower half.
+    * @return the upper half of this range.
+    */
+    Range split()
+    {
+        IndexType middle = begin + (end - begin) / 2;
+        Range upper(middle, end);
+        end = middle;
+        return upper;
+    }
+
+    IndexType begin;
+    IndexType end;
+};
+
+namespace detail
+{
+
+/**
+* State shared between all of the chunks of a single parallel loop.
+*  The last chunk to finish runs on_complete, posts the continuation, and deletes the state.
+*  The first exception thrown by a chunk is kept in error for on_complete.
+*/
+template<typename IndexType>
+struct ParallelLoop
+{
+    ParallelLoop(Honeydew* honeydew, IndexType grain, std::function<void(IndexType, IndexType)> body, size_t worker, uint64_t priority)
+        : honeydew(honeydew)
+        , grain(grain > 0 ? grain : 1)
+        , body(body)
+        , on_complete(nullptr)
+        , continuation(nullptr)
+        , error(nullptr)
+        , pending(1)
+        , worker(worker)
+        , priority(priority)
+    {
+    }
+
+    /**
+    * Runs a chunk of the loop. The range is split lazily: while it is larger than the grain
+    *  the upper half is posted as a new chunk (which will split itself further when it runs)
+    *  and the lower half is kept. This way the splitting is spread across the workers instead
+    *  of the posting thread creating one task per grain up front.
+    * @arg range the indices this chunk is responsible for.
+    */
+    void run(Range<IndexType> range)
+    {
+        while(range.size() > grain)
+        {
+            Range<IndexType> upper = range.split();
+            pending.increment();
+            task_t* task = new task_t([=] () { this->run(upper); }, worker, priority);
+            task->internal = true;
+            honeydew->post(task);
+        }
+
+        try
+        {
+            if(range.size() > 0)
+                body(range.begin, range.end);
+        }
+        catch(...)
+        {
+            {
+                std::unique_lock<std::mutex> lg(m);
+                if(error == nullptr)
+                    error = std::current_exception();
+            }
+            finish();
+            throw;
+        }
+        finish();
+    }
+
+    /**
+    * Marks one chunk as complete.
+    */
+    void finish()
+    {
+        if(pending.decrement() == 0)
+        {
+            if(on_complete)
+                on_complete();
+            if(continuation != nullptr)
+                honeydew->post(continuation);
+            delete this;
+        }
+    }
+
+    Honeydew* honeydew;
+    IndexType grain;
+    std::function<void(IndexType, IndexType)> body;
+    std::function<void()> on_complete;
+    task_t* continuation;
+    std::exception_ptr error;
+    std::mutex m;
+    join_semaphore_t pending;
+    size_t worker;
+    uint64_t priority;
+};
+
+/**
+* A per-worker partial result of a reduction, padded so neighbouring workers
+*  do not write to the same cache line.
+*/
+template<typename T>
+struct PartialResult
+{
+    PartialResult(const T& value)
+        : value(value)
+    {
+    }
+
+    T value;
+    char padding[64];
+};
+
+}
+
+/**
+* Wraps a loop over a Range into a task such that:
+*   1. The range is split into chunks of at most grain indices which run concurrently.
+*   2. The body is called once per chunk with the [begin, end) of that chunk. An empty or
+*       inverted range completes at once without calling it.
+*   3. [Optional] Once every chunk has completed the then task is posted.
+*/
+template<typename IndexType>
+class ParallelFor
+{
+public:
+
+    /**
+    * Creates a new parallel loop.
+    * @arg honeydew the Honeydew to post the chunks to.
+    * @arg range the indices to loop over.
+    * @arg grain the maximum number of indices handled by a single chunk.
+    * @arg body the function called with the [begin, end) of each chunk.
+    * @arg worker the worker to run the chunks on. Worker=0 means any worker.
+    * @arg priority the priority of the chunks.
+    */
+    ParallelFor(Honeydew* honeydew, Range<IndexType> range, IndexType grain, std::function<void(IndexType, IndexType)> body, size_t worker=0, uint64_t priority=0)
+        : honeydew(honeydew)
+        , range(range)
+        , grain(grain)
+        , body(body)
+        , worker(worker)
+        , priority(priority)
+    {
+    }
+
+    /**
+    * Sets the task that is posted once every chunk has completed.
+    * @arg other the Task wrapper to steal internals from.
+    * @return a reference to this for daisy chaining.
+    */
+    ParallelFor& then(Task&& other)
+    {
+        continuation = std::forward<Task>(other);
+        return *this;
+    }
+
+    /**
+    * Closes this loop and returns the underlying task_t*.
+    * @return the task_t* generated and ready to be pushed to a Honeydew.
+    */
+    task_t* close()
+    {
+        detail::ParallelLoop<IndexType>* loop = new detail::ParallelLoop<IndexType>(honeydew, grain, body, worker, priority);
+        loop->continuation = continuation.close();
+
+        Range<IndexType> range_copy = range;
+        return Task([=] () { loop->run(range_copy); }, worker, priority).close();
+    }
+
+private:
+    Honeydew* honeydew;
+    Range<IndexType> range;
+    IndexType grain;
+    std::function<void(IndexType, IndexType)> body;
+    size_t worker;
+    uint64_t priority;
+    Task continuation;
+};
+
+/**
+* Wraps a reduction over a Range into a task such that:
+*   1. The range is split into chunks of at most grain indices which run concurrently.
+*   2. The body is called once per chunk and its result is combined into the partial
+*       result of the worker running the chunk. Each worker only touches its own partial
+*       so no locking or atomic operations are performed on the values.
+*   3. Once every chunk has completed the partials are combined and passed to the then action.
+*       If a chunk threw, the result would lack that chunk: the first exception is passed to the
+*       on_error action instead and the then action isn't run.
+*/
+template<typename T, typename IndexType>
+class ParallelReduce
+{
+public:
+
+    /**
+    * Creates a new parallel reduction.
+    * @arg honeydew the Honeydew to post the chunks to.
+    * @arg range the indices to reduce over.
+    * @arg grain the maximum number of indices handled by a single chunk.
+    * @arg identity the identity value of combine. Each partial starts with this value.
+    * @arg body the function called with the [begin, end) of each chunk returning its result.
+    * @arg combine the function used to combine two results.
+    * @arg worker the worker to run the chunks on. Worker=0 means any worker.
+    * @arg priority the priority of the chunks.
+    */
+    ParallelReduce(Honeydew* honeydew, Range<IndexType> range, IndexType grain, T identity,
+                   std::function<T(IndexType, IndexType)> body, std::function<T(const T&, const T&)> combine,
+                   size_t worker=0, uint64_t priority=0)
+        : honeydew(honeydew)
+        , range(range)
+        , grain(grain)
+        , identity(identity)
+        , body(body)
+        , combine(combine)
+        , worker(worker)
+        , priority(priority)
+        , result_worker(0)
+        , result_priority(0)
+        , error_worker(0)
+        , error_priority(0)
+    {
+    }
+
+    /**
+    * Sets the action which receives the final result once every chunk has completed.
+    * @arg action the function to call with the result.
+    * @arg worker the worker to run the action upon.
+    * @arg priority the priority of the action.
+    * @return a reference to this for daisy chaining.
+    */
+    ParallelReduce& then(std::function<void(T)> action, size_t worker=0, uint64_t priority=0)
+    {
+        result_action = action;
+        result_worker = worker;
+        result_priority = priority;
+        return *this;
+    }
+
+    /**
+    * Sets the action which receives the first exception thrown by the body, in place of the result.
+    *  The exception is also passed to the Honeydew's exception handler as usual.
+    * @arg action the function to call with the exception.
+    * @arg worker the worker to run the action upon.
+    * @arg priority the priority of the action.
+    * @return a reference to this for daisy chaining.
+    */
+    ParallelReduce& on_error(std::function<void(std::exception_ptr)> action, size_t worker=0, uint64_t priority=0)
+    {
+        error_action = action;
+        error_worker = worker;
+        error_priority = priority;
+        return *this;
+    }
+
+    /**
+    * Closes this reduction and returns the underlying task_t*.
+    * @return the task_t* generated and ready to be pushed to a Honeydew.
+    */
+    task_t* close()
+    {
+        typedef std::vector<detail::PartialResult<T>> PartialsType;
+        PartialsType* partials = new PartialsType(honeydew->num_workers(), detail::PartialResult<T>(identity));
+
+        Honeydew* honeydew_copy = honeydew;
+        std::function<T(IndexType, IndexType)> body_copy = body;
+        std::function<T(const T&, const T&)> combine_copy = combine;
+        detail::ParallelLoop<IndexType>* loop = new detail::ParallelLoop<IndexType>(honeydew, grain,
+            [=] (IndexType begin, IndexType end) {
+                // The body may help run other chunks on this worker, so only
+                //   read the partial once it has returned.
+                T chunk_result = body_copy(begin, end);
+                T& partial = (*partials)[honeydew_copy->current_worker()].value;
+                partial = combine_copy(partial, chunk_result);
+            }, worker, priority);
+
+        T identity_copy = identity;
+        std::function<void(T)> action = result_action;
+        size_t action_worker = result_worker;
+        uint64_t action_priority = result_priority;
+        std::function<void(std::exception_ptr)> failed = error_action;
+        size_t failed_worker = error_worker;
+        uint64_t failed_priority = error_priority;
+        loop->on_complete = [=] () {
+            if(loop->error != nullptr)
+            {
+                delete partials;
+                std::exception_ptr e = loop->error;
+                if(failed)
+                    honeydew_copy->post(new task_t([=] () { failed(e); }, failed_worker, failed_priority));
+                return;
+            }
+
+            T result = identity_copy;
+            for(size_t i=0; i < partials->size(); ++i)
+            {
+                result = combine_copy(result, (*partials)[i].value);
+            }
+            delete partials;
+
+            if(action)
+                honeydew_copy->post(new task_t([=] () { action(result); }, action_worker, action_priority));
+        };
+
+        Range<IndexType> range_copy = range;
+        return Task([=] () { loop->run(range_copy); }, worker, priority).close();
+    }
+
+private:
+    Honeydew* honeydew;
+    Range<IndexType> range;
+    IndexType grain;
+    T identity;
+    std::function<T(IndexType, IndexType)> body;
+    std::function<T(const T&, const T&)> combine;
+    size_t worker;
+    uint64_t priority;
+    std::function<void(T)> result_action;
+    size_t result_worker;
+    uint64_t result_priority;
+    std::function<void(std::exception_ptr)> error_action;
+    size_t error_worker;
+    uint64_t error_priority;
+};
+
+/**
+* Calls body once per chunk of at most grain indices of range, concurrently on the workers
+*  of the given Honeydew. The calling thread does not return until every chunk has completed.
+*  If it is a worker it keeps running tasks while waiting, so loops can be nested.
+* @arg honeydew the Honeydew to run the loop on.
+* @arg range the indices to loop over.
+* @arg grain the maximum number of indices handled by a single chunk.
+* @arg body a function taking the (begin, end) of a chunk.
+*/
+template<typename IndexType, typename BodyType>
+void parallel_for(Honeydew* honeydew, Range<IndexType> range, typename Range<IndexType>::index_type grain, BodyType body)
+{
+    WaitFlag complete;
+
+    honeydew->post(ParallelFor<IndexType>(honeydew, range, grain, body).then(Task([&] () {
+        complete.set();
+    })));
+
+    complete.wait(honeydew);
+}
+
+/**
+* Reduces range with the workers of the given Honeydew. The calling thread does not return
+*  until the result is available. If it is a worker it keeps running tasks while waiting.
+*  If the body throws, the first exception is rethrown here instead of returning a partial result.
+* @arg honeydew the Honeydew to run the reduction on.
+* @arg range the indices to reduce over.
+* @arg grain the maximum number of indices handled by a single chunk.
+* @arg identity the identity value of combine.
+* @arg body a function taking the (begin, end) of a chunk and returning its T result.
+* @arg combine a function taking two T values and returning their combination.
+* @return the combination of the results of every chunk.
+*/
+template<typename T, typename IndexType, typename BodyType, typename CombineType>
+T parallel_reduce(Honeydew* honeydew, Range<IndexType> range, typename Range<IndexType>::index_type grain, T identity, BodyType body, CombineType combine)
+{
+    WaitFlag complete;
+    T result = identity;
+    std::exception_ptr error = nullptr;
+
+    honeydew->post(ParallelReduce<T, IndexType>(honeydew, range, grain, identity, body, combine).then([&] (T value) {
+        result = value;
+        complete.set();
+    }).on_error([&] (std::exception_ptr e) {
+        error = e;
+        complete.set();
+    }));
+
+    complete.wait(honeydew);
+    if(error != nullptr)
+        std::rethrow_exception(error);
+    return result;
+}
+
+}
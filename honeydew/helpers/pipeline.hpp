@@ -4,7 +4,12 @@
 
 #include <honeydew/helpers/task_wrapper.hpp>
 #include <honeydew/detail/join_semaphore.hpp>
+#include <honeydew/detail/block_pool.hpp>
 
+#include <atomic>
+#include <new>
+#include <memory>
+#include <vector>
 #include <utility>
 #include <type_traits>
 
@@ -17,12 +22,16 @@ namespace detail
 template<class PrevReturn> struct Pipeline;
 template<class PrevReturn> struct ForkedPipeline;
 template<typename TupleType, typename PrevReturn, size_t Current> struct TupledPipeline;
+template<class ForkReturn, class BranchReturn> struct GatherPipeline;
+template<class BranchReturn> struct GatherSlots;
 
 }
 }
 
+#include <honeydew/helpers/pipelines/result_slot.hpp>
 #include <honeydew/helpers/pipelines/void.hpp>
 #include <honeydew/helpers/pipelines/forked.hpp>
+#include <honeydew/helpers/pipelines/gather.hpp>
 #include <honeydew/helpers/pipelines/nonvoid.hpp>
 
 namespace honeydew
@@ -30,6 +39,12 @@ namespace honeydew
 
 /**
 * Struct containing static methods to create a pipeline of tasks.
+*  Each stage's return value is constructed in place from what the stage returns and moved into
+*  the next stage, so result types need no default constructor and may be move-only. The input of
+*  a fork is shared by its concurrent tasks, each of which receives a copy.
+*  If a stage throws, the stages which would receive its value are skipped.
+*  Closing a pipeline fuses consecutive stages which share a worker and priority into one task
+*  (see Task::fuse), so chains of small stages don't pay for a queue round trip each.
 */
 struct Pipeline
 {
@@ -43,8 +58,8 @@ struct Pipeline
     template<typename ReturnType>
     static detail::Pipeline<ReturnType> start(std::function<ReturnType()> action, size_t worker=0, uint64_t deadline=0)
     {
-        ReturnType* result = new ReturnType();
-        Task task([=] () { *result = action(); }, worker, deadline);
+        detail::ResultSlot<ReturnType>* result = detail::ResultSlot<ReturnType>::create();
+        Task task([=] () { result->fill(action); }, worker, deadline);
         return detail::Pipeline<ReturnType>(std::move(task), result);
     }
     
@@ -59,8 +74,11 @@ struct Pipeline
     static detail::ForkedPipeline<ReturnType> start_forked(std::function<ReturnType()> action, size_t worker=0, uint64_t deadline=0)
     {
         join_semaphore_t* join_sem = new join_semaphore_t(1);
-        ReturnType* result = new ReturnType();
-        Task task([=] () { *result = action(); }, worker, deadline);
+        detail::ResultSlot<ReturnType>* result = detail::ResultSlot<ReturnType>::create();
+        Task task([=] () { result->fill(action); }, worker, deadline);
+
+        // The fork's tasks run alongside this stage, after the value is ready. It holds the initial share.
+        task.then([=] () { detail::ForkShare<ReturnType> share(result, join_sem); }, worker);
         return detail::ForkedPipeline<ReturnType>(std::move(task), result, join_sem);
     }
 };
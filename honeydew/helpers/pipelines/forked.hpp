@@ -12,14 +12,14 @@ struct ForkedPipeline
 {
 
     Task task;
-    ForkReturn* prev_return;
+    ResultSlot<ForkReturn>* prev_return;
     join_semaphore_t* join_sem;
 
     /**
     * Extends the current forked pipeline. To create a new Forked pipeline use
     *  Pipeline::startForked() instead.
     */
-    ForkedPipeline(Task&& task, ForkReturn* result, join_semaphore_t* join_sem)
+    ForkedPipeline(Task&& task, ResultSlot<ForkReturn>* result, join_semaphore_t* join_sem)
         : task(std::forward<Task>(task))
         , prev_return(result)
         , join_sem(join_sem)
@@ -36,17 +36,14 @@ struct ForkedPipeline
     template<typename ReturnValue>
     ForkedPipeline<ForkReturn> also(std::function<ReturnValue(ForkReturn)> action, size_t worker=0, uint64_t deadline=0)
     {
-        auto& join_sem_ref = join_sem;
-        auto& prev_return_ref = prev_return;
+        ResultSlot<ForkReturn>* prev = prev_return;
+        join_semaphore_t* sem = join_sem;
 
         join_sem->increment();
-        task.also([=] () { 
-            action(*prev_return_ref);
-            if(join_sem_ref->decrement() == 0)
-            {
-                delete join_sem_ref;
-                delete prev_return_ref;
-            }
+        task.also([=] () {
+            ForkShare<ForkReturn> share(prev, sem);
+            if(prev->has_value())
+                action(prev->value());
         }, worker, deadline);
         return ForkedPipeline<ForkReturn>(std::move(task), prev_return, join_sem);
     }
@@ -61,17 +58,14 @@ struct ForkedPipeline
     template<typename ReturnValue>
     ForkedPipeline<ForkReturn> also_absolute(std::function<ReturnValue(ForkReturn)> action, size_t worker=0, uint64_t deadline=0)
     {
-        auto& join_sem_ref = join_sem;
-        auto& prev_return_ref = prev_return;
+        ResultSlot<ForkReturn>* prev = prev_return;
+        join_semaphore_t* sem = join_sem;
 
         join_sem->increment();
-        task.also_absolute([=] () { 
-            action(*prev_return_ref);
-            if(join_sem_ref->decrement() == 0)
-            {
-                delete join_sem_ref;
-                delete prev_return_ref;
-            }
+        task.also_absolute([=] () {
+            ForkShare<ForkReturn> share(prev, sem);
+            if(prev->has_value())
+                action(prev->value());
         }, worker, deadline);
         return ForkedPipeline<ForkReturn>(std::move(task), prev_return, join_sem);
     }
@@ -86,17 +80,14 @@ struct ForkedPipeline
     template<typename ReturnValue>
     ForkedPipeline<ForkReturn> fork(std::function<ReturnValue(ForkReturn)> action, size_t worker=0, uint64_t deadline=0)
     {
-        auto& join_sem_ref = join_sem;
-        auto& prev_return_ref = prev_return;
+        ResultSlot<ForkReturn>* prev = prev_return;
+        join_semaphore_t* sem = join_sem;
 
         join_sem->increment();
         task.fork([=] () {
-            action(*prev_return_ref);
-            if(join_sem_ref->decrement() == 0)
-            {
-                delete join_sem_ref;
-                delete prev_return_ref;
-            }
+            ForkShare<ForkReturn> share(prev, sem);
+            if(prev->has_value())
+                action(prev->value());
         }, worker, deadline);
         return ForkedPipeline<ForkReturn>(std::move(task), prev_return, join_sem);
     }
@@ -111,21 +102,48 @@ struct ForkedPipeline
     template<typename ReturnValue>
     ForkedPipeline<ForkReturn> fork_absolute(std::function<ReturnValue(ForkReturn)> action, size_t worker=0, uint64_t deadline=0)
     {
-        auto& join_sem_ref = join_sem;
-        auto& prev_return_ref = prev_return;
+        ResultSlot<ForkReturn>* prev = prev_return;
+        join_semaphore_t* sem = join_sem;
 
         join_sem->increment();
         task.fork_absolute([=] () {
-            action(*prev_return_ref);
-            if(join_sem_ref->decrement() == 0)
-            {
-                delete join_sem_ref;
-                delete prev_return_ref;
-            }
+            ForkShare<ForkReturn> share(prev, sem);
+            if(prev->has_value())
+                action(prev->value());
         }, worker, deadline);
         return ForkedPipeline<ForkReturn>(std::move(task), prev_return, join_sem);
     }
 
+    /**
+    * Adds a concurrently running task to be performed with the value returned at the start of the fork
+    *  whose return value is kept. Further scattered tasks can be added to the returned pipeline and their
+    *  results are handed together to its gather() or reduce().
+    * @arg action the function to run.
+    * @arg worker the worker to run this task upon.
+    * @arg deadline the priority of this task. This value is relative to the previous task.
+    */
+    template<typename BranchReturn>
+    GatherPipeline<ForkReturn, BranchReturn> scatter(std::function<BranchReturn(ForkReturn)> action, size_t worker=0, uint64_t deadline=0)
+    {
+        return GatherPipeline<ForkReturn, BranchReturn>(std::move(task), prev_return, join_sem, new GatherSlots<BranchReturn>())
+            .scatter(action, worker, deadline);
+    }
+
+    /**
+    * Adds a concurrently running task to be performed with the value returned at the start of the fork
+    *  whose return value is kept. Further scattered tasks can be added to the returned pipeline and their
+    *  results are handed together to its gather() or reduce().
+    * @arg action the function to run.
+    * @arg worker the worker to run this task upon.
+    * @arg deadline the priority of this task. This value is absolute.
+    */
+    template<typename BranchReturn>
+    GatherPipeline<ForkReturn, BranchReturn> scatter_absolute(std::function<BranchReturn(ForkReturn)> action, size_t worker=0, uint64_t deadline=0)
+    {
+        return GatherPipeline<ForkReturn, BranchReturn>(std::move(task), prev_return, join_sem, new GatherSlots<BranchReturn>())
+            .scatter_absolute(action, worker, deadline);
+    }
+
     /**
     * Joins this fork back into a normal pipeline. The return value of this function will be passed into
     *  the next stage of the pipeline as normal.
@@ -135,17 +153,14 @@ struct ForkedPipeline
     */
     Pipeline<void> join(std::function<void(ForkReturn)> action, size_t worker=0, uint64_t deadline=0)
     {
-        auto& join_sem_ref = join_sem;
-        auto& prev_return_ref = prev_return;
+        ResultSlot<ForkReturn>* prev = prev_return;
+        join_semaphore_t* sem = join_sem;
 
         join_sem->increment();
-        task.also([=] () { 
-            action(*prev_return_ref);
-            if(join_sem_ref->decrement() == 0)
-            {
-                delete join_sem_ref;
-                delete prev_return_ref;
-            }
+        task.also([=] () {
+            ForkShare<ForkReturn> share(prev, sem);
+            if(prev->has_value())
+                action(prev->value());
         }, worker, deadline);
         return Pipeline<void>(std::move(task));
     }
@@ -159,17 +174,14 @@ struct ForkedPipeline
     */
     Pipeline<void> join_absolute(std::function<void(ForkReturn)> action, size_t worker=0, uint64_t deadline=0)
     {
-        auto& join_sem_ref = join_sem;
-        auto& prev_return_ref = prev_return;
+        ResultSlot<ForkReturn>* prev = prev_return;
+        join_semaphore_t* sem = join_sem;
 
         join_sem->increment();
-        task.also_absolute([=] () { 
-            action(*prev_return_ref);
-            if(join_sem_ref->decrement() == 0)
-            {
-                delete join_sem_ref;
-                delete prev_return_ref;
-            }
+        task.also_absolute([=] () {
+            ForkShare<ForkReturn> share(prev, sem);
+            if(prev->has_value())
+                action(prev->value());
         }, worker, deadline);
         return Pipeline<void>(std::move(task));
     }
@@ -184,18 +196,15 @@ struct ForkedPipeline
     template<typename ReturnType>
     Pipeline<ReturnType> join(std::function<ReturnType(ForkReturn)> action, size_t worker=0, uint64_t deadline=0)
     {
-        ReturnType* result = new ReturnType();
-        auto& join_sem_ref = join_sem;
-        auto& prev_return_ref = prev_return;
+        ResultSlot<ReturnType>* result = ResultSlot<ReturnType>::create();
+        ResultSlot<ForkReturn>* prev = prev_return;
+        join_semaphore_t* sem = join_sem;
 
         join_sem->increment();
-        task.also([=] () { 
-            *result = action(*prev_return_ref);
-            if(join_sem_ref->decrement() == 0)
-            {
-                delete join_sem_ref;
-                delete prev_return_ref;
-            }
+        task.also([=] () {
+            ForkShare<ForkReturn> share(prev, sem);
+            if(prev->has_value())
+                result->fill(action, prev->value());
         }, worker, deadline);
         return Pipeline<ReturnType>(std::move(task), result);
     }
@@ -210,18 +219,15 @@ struct ForkedPipeline
     template<typename ReturnType>
     Pipeline<ReturnType> join_absolute(std::function<ReturnType(ForkReturn)> action, size_t worker=0, uint64_t deadline=0)
     {
-        ReturnType* result = new ReturnType();
-        auto& join_sem_ref = join_sem;
-        auto& prev_return_ref = prev_return;
+        ResultSlot<ReturnType>* result = ResultSlot<ReturnType>::create();
+        ResultSlot<ForkReturn>* prev = prev_return;
+        join_semaphore_t* sem = join_sem;
 
         join_sem->increment();
-        task.also_absolute([=] () { 
-            *result = action(*prev_return_ref);
-            if(join_sem_ref->decrement() == 0)
-            {
-                delete join_sem_ref;
-                delete prev_return_ref;
-            }
+        task.also_absolute([=] () {
+            ForkShare<ForkReturn> share(prev, sem);
+            if(prev->has_value())
+                result->fill(action, prev->value());
         }, worker, deadline);
         return Pipeline<ReturnType>(std::move(task), result);
     }
@@ -232,7 +238,7 @@ struct ForkedPipeline
     */
     task_t* close()
     {
-        return task.close();
+        return task.fuse().close();
     }
 };
 
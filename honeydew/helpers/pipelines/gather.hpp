@@ -0,0 +1,212 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+#pragma once
+
+namespace honeydew
+{
+namespace detail
+{
+
+/**
+* The slots the branches of a scatter write their results into, one per branch.
+*  The slots are allocated while the pipeline is built so the branches never synchronize:
+*  each writes its own slot and the join reads them all once the branches are done.
+*/
+template<typename BranchReturn>
+struct GatherSlots
+{
+    GatherSlots()
+        : no_input(false)
+    {
+    }
+
+    ~GatherSlots()
+    {
+        for(size_t i=0; i < slots.size(); ++i)
+        {
+            ResultSlot<BranchReturn>::destroy(slots[i]);
+        }
+    }
+
+    /**
+    * Moves the results out of the slots in branch order. Branches which threw have no result.
+    */
+    std::vector<BranchReturn> take()
+    {
+        std::vector<BranchReturn> values;
+        values.reserve(slots.size());
+        for(size_t i=0; i < slots.size(); ++i)
+        {
+            if(slots[i]->has_value())
+                values.push_back(std::move(slots[i]->value()));
+        }
+        return values;
+    }
+
+    std::vector<ResultSlot<BranchReturn>*> slots;
+
+    // Set by the branches when the fork's input stage threw, so there was nothing to scatter.
+    std::atomic<bool> no_input;
+};
+
+template<typename ForkReturn, typename BranchReturn>
+struct GatherPipeline
+{
+    Task task;
+    ResultSlot<ForkReturn>* prev_return;
+    join_semaphore_t* join_sem;
+    GatherSlots<BranchReturn>* gathered;
+
+    /**
+    * Extends a forked pipeline with branches whose results are gathered.
+    *  To start one use ForkedPipeline::scatter() instead.
+    */
+    GatherPipeline(Task&& task, ResultSlot<ForkReturn>* result, join_semaphore_t* join_sem, GatherSlots<BranchReturn>* gathered)
+        : task(std::forward<Task>(task))
+        , prev_return(result)
+        , join_sem(join_sem)
+        , gathered(gathered)
+    {
+    }
+
+    /**
+    * Adds another concurrently running task to be performed with the value returned at the start of the fork.
+    *  Its return value is kept for the gather.
+    * @arg action the function to run.
+    * @arg worker the worker to run this task upon.
+    * @arg deadline the priority of this task. This value is relative to the previous task.
+    */
+    GatherPipeline<ForkReturn, BranchReturn> scatter(std::function<BranchReturn(ForkReturn)> action, size_t worker=0, uint64_t deadline=0)
+    {
+        task.also(branch(action), worker, deadline);
+        return GatherPipeline<ForkReturn, BranchReturn>(std::move(task), prev_return, join_sem, gathered);
+    }
+
+    /**
+    * Adds another concurrently running task to be performed with the value returned at the start of the fork.
+    *  Its return value is kept for the gather.
+    * @arg action the function to run.
+    * @arg worker the worker to run this task upon.
+    * @arg deadline the priority of this task. This value is absolute.
+    */
+    GatherPipeline<ForkReturn, BranchReturn> scatter_absolute(std::function<BranchReturn(ForkReturn)> action, size_t worker=0, uint64_t deadline=0)
+    {
+        task.also_absolute(branch(action), worker, deadline);
+        return GatherPipeline<ForkReturn, BranchReturn>(std::move(task), prev_return, join_sem, gathered);
+    }
+
+    /**
+    * Joins the fork once every task in it has finished. The results of the scattered tasks are
+    *  passed in the order they were added; a task which threw has no result. If the fork's input
+    *  stage threw, this task and the stages after it are skipped.
+    * @arg action the task to perform.
+    * @arg worker the thread to run this task upon.
+    * @arg deadline the priority of this task. This value is relative to the previous task.
+    */
+    template<typename ReturnType>
+    Pipeline<ReturnType> gather(std::function<ReturnType(std::vector<BranchReturn>)> action, size_t worker=0, uint64_t deadline=0)
+    {
+        ResultSlot<ReturnType>* result = ResultSlot<ReturnType>::create();
+        task.then(join(result, action), worker, deadline);
+        return Pipeline<ReturnType>(std::move(task), result);
+    }
+
+    /**
+    * Joins the fork once every task in it has finished. The results of the scattered tasks are
+    *  passed in the order they were added; a task which threw has no result. If the fork's input
+    *  stage threw, this task and the stages after it are skipped.
+    * @arg action the task to perform.
+    * @arg worker the thread to run this task upon.
+    * @arg deadline the priority of this task. This value is absolute.
+    */
+    template<typename ReturnType>
+    Pipeline<ReturnType> gather_absolute(std::function<ReturnType(std::vector<BranchReturn>)> action, size_t worker=0, uint64_t deadline=0)
+    {
+        ResultSlot<ReturnType>* result = ResultSlot<ReturnType>::create();
+        task.then_absolute(join(result, action), worker, deadline);
+        return Pipeline<ReturnType>(std::move(task), result);
+    }
+
+    /**
+    * Joins the fork once every task in it has finished by folding the results of the scattered
+    *  tasks, in the order they were added, with the given operation. The folded value is passed
+    *  to the next stage, which is skipped if no scattered task returned a value.
+    * @arg op the reduction, called as op(accumulated, next).
+    * @arg worker the thread to run the reduction upon.
+    * @arg deadline the priority of this task. This value is relative to the previous task.
+    */
+    Pipeline<BranchReturn> reduce(std::function<BranchReturn(BranchReturn, BranchReturn)> op, size_t worker=0, uint64_t deadline=0)
+    {
+        ResultSlot<BranchReturn>* result = ResultSlot<BranchReturn>::create();
+        task.then(fold(result, op), worker, deadline);
+        return Pipeline<BranchReturn>(std::move(task), result);
+    }
+
+    /**
+    * Joins the fork once every task in it has finished by folding the results of the scattered
+    *  tasks, in the order they were added, with the given operation. The folded value is passed
+    *  to the next stage, which is skipped if no scattered task returned a value.
+    * @arg op the reduction, called as op(accumulated, next).
+    * @arg worker the thread to run the reduction upon.
+    * @arg deadline the priority of this task. This value is absolute.
+    */
+    Pipeline<BranchReturn> reduce_absolute(std::function<BranchReturn(BranchReturn, BranchReturn)> op, size_t worker=0, uint64_t deadline=0)
+    {
+        ResultSlot<BranchReturn>* result = ResultSlot<BranchReturn>::create();
+        task.then_absolute(fold(result, op), worker, deadline);
+        return Pipeline<BranchReturn>(std::move(task), result);
+    }
+
+private:
+
+    std::function<void()> branch(std::function<BranchReturn(ForkReturn)> action)
+    {
+        ResultSlot<ForkReturn>* prev = prev_return;
+        join_semaphore_t* sem = join_sem;
+        GatherSlots<BranchReturn>* slots = gathered;
+        ResultSlot<BranchReturn>* slot = ResultSlot<BranchReturn>::create();
+        gathered->slots.push_back(slot);
+
+        join_sem->increment();
+        return [=] () {
+            ForkShare<ForkReturn> share(prev, sem);
+            if(prev->has_value())
+                slot->fill(action, prev->value());
+            else
+                slots->no_input.store(true);
+        };
+    }
+
+    template<typename ReturnType>
+    std::function<void()> join(ResultSlot<ReturnType>* result, std::function<ReturnType(std::vector<BranchReturn>)> action)
+    {
+        GatherSlots<BranchReturn>* slots = gathered;
+        return [=] () {
+            std::unique_ptr<GatherSlots<BranchReturn>> guard(slots);
+            if(slots->no_input.load())
+                return;
+            result->fill(action, slots->take());
+        };
+    }
+
+    std::function<void()> fold(ResultSlot<BranchReturn>* result, std::function<BranchReturn(BranchReturn, BranchReturn)> op)
+    {
+        GatherSlots<BranchReturn>* slots = gathered;
+        return [=] () {
+            std::unique_ptr<GatherSlots<BranchReturn>> guard(slots);
+            std::vector<BranchReturn> values = slots->take();
+            if(values.empty())
+                return;
+
+            BranchReturn accumulated = std::move(values[0]);
+            for(size_t i=1; i < values.size(); ++i)
+            {
+                accumulated = op(std::move(accumulated), std::move(values[i]));
+            }
+            result->fill([&] () { return std::move(accumulated); });
+        };
+    }
+};
+
+}
+}
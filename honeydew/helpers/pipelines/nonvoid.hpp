@@ -11,13 +11,13 @@ template<class PrevReturn>
 struct Pipeline
 {
     Task task;
-    PrevReturn* prev_result;
+    ResultSlot<PrevReturn>* prev_result;
 
     /**
     * Constructor that extends the current pipeline.
     *   to create a new pipeline use Pipeline::start() instead.
     */
-    Pipeline(Task&& task, PrevReturn* result)
+    Pipeline(Task&& task, ResultSlot<PrevReturn>* result)
         : task(std::forward<Task>(task))
         , prev_result(result)
     {
@@ -33,8 +33,8 @@ struct Pipeline
     */ 
     Pipeline<void> then(std::function<void(PrevReturn)> action, size_t worker=0, uint64_t deadline=0)
     {
-        auto& prev_result_ref = prev_result;
-        task.then([=] () { action(*prev_result_ref); delete prev_result_ref; }, worker, deadline);
+        ResultSlot<PrevReturn>* prev = prev_result;
+        task.then([=] () { consume(prev, action); }, worker, deadline);
         return Pipeline<void>(std::move(task));
     }
     
@@ -48,8 +48,8 @@ struct Pipeline
     */ 
     Pipeline<void> then_absolute(std::function<void(PrevReturn)> action, size_t worker=0, uint64_t deadline=0)
     {
-        auto& prev_result_ref = prev_result;
-        task.then_absolute([=] () { action(*prev_result_ref); delete prev_result_ref; }, worker, deadline);
+        ResultSlot<PrevReturn>* prev = prev_result;
+        task.then_absolute([=] () { consume(prev, action); }, worker, deadline);
         return Pipeline<void>(std::move(task));
     }
 
@@ -64,9 +64,9 @@ struct Pipeline
     template<typename ReturnType>
     Pipeline<ReturnType> then(std::function<ReturnType(PrevReturn)> action, size_t worker=0, uint64_t deadline=0)
     {
-        auto& prev_result_ref = prev_result;
-        ReturnType* result = new ReturnType();
-        task.then([=] () { *result = action(*prev_result_ref); delete prev_result_ref; }, worker, deadline);
+        ResultSlot<PrevReturn>* prev = prev_result;
+        ResultSlot<ReturnType>* result = ResultSlot<ReturnType>::create();
+        task.then([=] () { consume(prev, result, action); }, worker, deadline);
         return Pipeline<ReturnType>(std::move(task), result);
     }
    
@@ -81,9 +81,9 @@ struct Pipeline
     template<typename ReturnType>
     Pipeline<ReturnType> then_absolute(std::function<ReturnType(PrevReturn)> action, size_t worker=0, uint64_t deadline=0)
     {
-        auto& prev_result_ref = prev_result;
-        ReturnType* result = new ReturnType();
-        task.then_absolute(worker, [=] () { *result = action(*prev_result_ref); delete prev_result_ref; }, deadline);
+        ResultSlot<PrevReturn>* prev = prev_result;
+        ResultSlot<ReturnType>* result = ResultSlot<ReturnType>::create();
+        task.then_absolute([=] () { consume(prev, result, action); }, worker, deadline);
         return Pipeline<ReturnType>(std::move(task), result);
     }
 
@@ -97,9 +97,9 @@ struct Pipeline
     template<typename ReturnType>
     task_t* close_with(std::function<ReturnType(PrevReturn)> action, size_t worker=0, uint64_t deadline=0)
     {
-        auto& prev_result_ref = prev_result;
-        task.then([=] () { action(*prev_result_ref); delete prev_result_ref; }, worker, deadline);
-        return task.close();
+        ResultSlot<PrevReturn>* prev = prev_result;
+        task.then([=] () { consume(prev, action); }, worker, deadline);
+        return task.fuse().close();
     }
     
     /**
@@ -112,55 +112,51 @@ struct Pipeline
     template<typename ReturnType>
     task_t* close_with_absolute(std::function<ReturnType(PrevReturn)> action, size_t worker=0, uint64_t deadline=0)
     {
-        auto& prev_result_ref = prev_result;
-        task.then_absolute([=] () { action(*prev_result_ref); delete prev_result_ref; }, worker, deadline);
-        return task.close();
+        ResultSlot<PrevReturn>* prev = prev_result;
+        task.then_absolute([=] () { consume(prev, action); }, worker, deadline);
+        return task.fuse().close();
     }
     
     /**
     * Starts a new fork. The given function will run alongside the following functions until after a corresponding join.
+    *  Every function of the fork receives a copy of the previous stage's value. The return value of this one is discarded.
     * @arg action the action to execute
     * @arg worker the worker to run this action upon.
     * @arg deadline a priority value to use. This value is relative to the previous priority.
     * @return A forked pipeline object. This is used to daisy chain calls.
     */
     template<typename ReturnType>
-    ForkedPipeline<ReturnType> split(std::function<ReturnType(PrevReturn)> action, size_t worker=0, uint64_t deadline=0)
+    ForkedPipeline<PrevReturn> split(std::function<ReturnType(PrevReturn)> action, size_t worker=0, uint64_t deadline=0)
     {
-        auto& prev_result_ref = prev_result;
+        ResultSlot<PrevReturn>* prev = prev_result;
         join_semaphore_t* join_sem = new join_semaphore_t(1);
-        task.then([=] () { 
-            action(*prev_result_ref); 
-            if(join_sem->decrement() == 0)
-            {
-                delete join_sem;
-                delete prev_result_ref;
-            }
+        task.then([=] () {
+            ForkShare<PrevReturn> share(prev, join_sem);
+            if(prev->has_value())
+                action(prev->value());
         }, worker, deadline);
-        return ForkedPipeline<ReturnType>(std::move(task), prev_result, join_sem);
+        return ForkedPipeline<PrevReturn>(std::move(task), prev_result, join_sem);
     }
 
     /**
     * Starts a new fork. The given function will run alongside the following functions until after a corresponding join.
+    *  Every function of the fork receives a copy of the previous stage's value. The return value of this one is discarded.
     * @arg action the action to execute
     * @arg worker the worker to run this action upon
     * @arg deadline a priority value to use. This value is absolute.
     * @return A forked pipeline object. This is used to daisy chain calls.
     */
     template<typename ReturnType>
-    ForkedPipeline<ReturnType> split_absolute(std::function<ReturnType(PrevReturn)> action, size_t worker=0, uint64_t deadline=0)
+    ForkedPipeline<PrevReturn> split_absolute(std::function<ReturnType(PrevReturn)> action, size_t worker=0, uint64_t deadline=0)
     {
-        auto& prev_result_ref = prev_result;
+        ResultSlot<PrevReturn>* prev = prev_result;
         join_semaphore_t* join_sem = new join_semaphore_t(1);
-        task.then_absolute([=] () { 
-            action(*prev_result_ref);
-            if(join_sem->decrement() == 0)
-            {
-                delete join_sem;
-                delete prev_result_ref;
-            }
+        task.then_absolute([=] () {
+            ForkShare<PrevReturn> share(prev, join_sem);
+            if(prev->has_value())
+                action(prev->value());
         }, worker, deadline);
-        return ForkedPipeline<ReturnType>(std::move(task), prev_result, join_sem);
+        return ForkedPipeline<PrevReturn>(std::move(task), prev_result, join_sem);
     }
 
     /**
@@ -169,8 +165,9 @@ struct Pipeline
     */    
     task_t* close()
     {
-        task.then([=] () { delete prev_result; });
-        return task.close();
+        ResultSlot<PrevReturn>* prev = prev_result;
+        task.then([=] () { ResultSlot<PrevReturn>::destroy(prev); });
+        return task.fuse().close();
     }
 
 };
@@ -0,0 +1,142 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+#pragma once
+
+namespace honeydew
+{
+namespace detail
+{
+
+/**
+* Holds the value a pipeline stage returned until the next stage takes it. The value is
+*  constructed in place from the stage's return value, so it needs no default constructor,
+*  and the next stage receives it moved, so move-only types such as std::unique_ptr work.
+*  Slots come from the BlockPool.
+*  A slot stays empty if the stage filling it threw, in which case the stages reading it are skipped.
+*/
+template<typename T>
+class ResultSlot
+{
+public:
+
+    static ResultSlot* create()
+    {
+        return BlockPool::create<ResultSlot>();
+    }
+
+    static void destroy(ResultSlot* slot)
+    {
+        BlockPool::destroy(slot);
+    }
+
+    ResultSlot()
+        : full(false)
+    {
+    }
+
+    ~ResultSlot()
+    {
+        if(full)
+            value().~T();
+    }
+
+    /**
+    * Deleted copy constructor & copy assignment
+    */
+    ResultSlot(const ResultSlot& other) = delete;
+    ResultSlot& operator=(const ResultSlot& other) = delete;
+
+    /**
+    * Constructs the value from the result of action(args...).
+    */
+    template<typename FunctorType, typename... Args>
+    void fill(const FunctorType& action, Args&&... args)
+    {
+        new (&storage) T(action(std::forward<Args>(args)...));
+        full = true;
+    }
+
+    bool has_value() const
+    {
+        return full;
+    }
+
+    T& value()
+    {
+        return *reinterpret_cast<T*>(&storage);
+    }
+
+private:
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    bool full;
+};
+
+/**
+* Frees a slot when it goes out of scope, so it isn't leaked by a stage which throws.
+*/
+template<typename T>
+struct SlotGuard
+{
+    SlotGuard(ResultSlot<T>* slot)
+        : slot(slot)
+    {
+    }
+
+    ~SlotGuard()
+    {
+        ResultSlot<T>::destroy(slot);
+    }
+
+    ResultSlot<T>* slot;
+};
+
+/**
+* Releases one task's share of a slot read by the concurrent tasks of a fork.
+*  The last task to finish frees the slot and the join semaphore.
+*/
+template<typename T>
+struct ForkShare
+{
+    ForkShare(ResultSlot<T>* slot, join_semaphore_t* join_sem)
+        : slot(slot)
+        , join_sem(join_sem)
+    {
+    }
+
+    ~ForkShare()
+    {
+        if(join_sem->decrement() == 0)
+        {
+            delete join_sem;
+            ResultSlot<T>::destroy(slot);
+        }
+    }
+
+    ResultSlot<T>* slot;
+    join_semaphore_t* join_sem;
+};
+
+/**
+* Passes the value of prev (moved) to action and frees prev.
+*/
+template<typename PrevReturn, typename FunctorType>
+void consume(ResultSlot<PrevReturn>* prev, const FunctorType& action)
+{
+    SlotGuard<PrevReturn> guard(prev);
+    if(prev->has_value())
+        action(std::move(prev->value()));
+}
+
+/**
+* Passes the value of prev (moved) to action, constructs result from its return value and frees prev.
+*/
+template<typename PrevReturn, typename ReturnType, typename FunctorType>
+void consume(ResultSlot<PrevReturn>* prev, ResultSlot<ReturnType>* result, const FunctorType& action)
+{
+    SlotGuard<PrevReturn> guard(prev);
+    if(prev->has_value())
+        result->fill(action, std::move(prev->value()));
+}
+
+}
+}
@@ -114,8 +114,8 @@ struct Pipeline<void>
     template<typename ReturnType>
     Pipeline<ReturnType> then(std::function<ReturnType()> action, size_t worker=0, uint64_t deadline=0)
     {
-        ReturnType* result = new ReturnType();
-        task.then([=] () { *result = action(); }, worker, deadline);
+        ResultSlot<ReturnType>* result = ResultSlot<ReturnType>::create();
+        task.then([=] () { result->fill(action); }, worker, deadline);
         return Pipeline<ReturnType>(std::move(task), result);
     }
 
@@ -130,8 +130,8 @@ struct Pipeline<void>
     template<typename ReturnType>
     Pipeline<ReturnType> then_abolute(std::function<ReturnType()> action, size_t worker=0, uint64_t deadline=0)
     {
-        ReturnType* result = new ReturnType();
-        task.then_absolute(worker, [=] () { *result = action(); }, deadline);
+        ResultSlot<ReturnType>* result = ResultSlot<ReturnType>::create();
+        task.then_absolute([=] () { result->fill(action); }, worker, deadline);
         return Pipeline<ReturnType>(std::move(task), result);
     }
 
@@ -145,8 +145,8 @@ struct Pipeline<void>
     template<typename ReturnType>
     Pipeline<ReturnType> also(std::function<ReturnType()> action, size_t worker=0, uint64_t deadline=0)
     {
-        ReturnType* result = new ReturnType();
-        task.also([=] () { *result = action(); }, worker, deadline);
+        ResultSlot<ReturnType>* result = ResultSlot<ReturnType>::create();
+        task.also([=] () { result->fill(action); }, worker, deadline);
         return Pipeline<ReturnType>(std::move(task), result);
     }
 
@@ -160,8 +160,8 @@ struct Pipeline<void>
     template<typename ReturnType>
     Pipeline<ReturnType> also_absolute(std::function<ReturnType()> action, size_t worker=0, uint64_t deadline=0)
     {
-        ReturnType* result = new ReturnType();
-        task.also_absolute([=] () { *result = action(); }, worker, deadline);
+        ResultSlot<ReturnType>* result = ResultSlot<ReturnType>::create();
+        task.also_absolute([=] () { result->fill(action); }, worker, deadline);
         return Pipeline<ReturnType>(std::move(task), result);
     }
 
@@ -176,7 +176,7 @@ struct Pipeline<void>
     task_t* close_with(std::function<ReturnType()> action, size_t worker=0, uint64_t deadline=0)
     {
         task.then([=] () { action(); }, worker, deadline);
-        return task.close();
+        return task.fuse().close();
     }
     
     /**
@@ -190,7 +190,7 @@ struct Pipeline<void>
     task_t* close_with_absolute(std::function<ReturnType()> action, size_t worker=0, uint64_t deadline=0)
     {
         task.then_absolute([=] () { action(); }, worker, deadline);
-        return task.close();
+        return task.fuse().close();
     }
     
     /**
@@ -199,7 +199,7 @@ struct Pipeline<void>
     */
     task_t* close()
     {
-        return task.close();
+        return task.fuse().close();
     }
 };
 
@@ -9,12 +9,16 @@ namespace honeydew
 
 /**
 * Helper function which appends a then task to the end of the given task which
-*  sets a condition_variable. The calling thread blocks on this condition
-*  variable and will not resume until the task at the end of the Task structure
-*  sets the var.
+*  sets a WaitFlag. The calling thread does not return until the task at the end
+*  of the Task structure sets the flag.
+*  If the calling thread is a worker of the given Honeydew it keeps running tasks
+*   from its own queue while it waits, so waiting from inside a task neither idles
+*   the worker nor deadlocks on tasks pinned to it.
+*  Otherwise the calling thread spins up to spin_count times before sleeping.
 * @arg honeydew the Honeydew scheduler to post the task to.
 * @arg task the task to append the then relationship to.
+* @arg spin_count the number of times a non-worker thread checks for completion before sleeping.
 */    
-void post_and_wait(Honeydew* honeydew, Task& task);
+void post_and_wait(Honeydew* honeydew, Task& task, size_t spin_count=0);
 
 }
@@ -0,0 +1,398 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+#pragma once
+
+#include <honeydew/honeydew.hpp>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace honeydew
+{
+
+namespace detail
+{
+
+/**
+* A file descriptor registered with a Reactor.
+*/
+struct ReactorRegistration
+{
+    int fd;
+    uint32_t events;
+    uint32_t generation;
+    std::function<void(uint32_t)> handler;
+    size_t worker;
+    uint64_t priority;
+
+    // Set while a handler task is posted or running. The fd is disarmed meanwhile.
+    bool in_flight;
+};
+
+/**
+* The state of a Reactor which handler tasks share, so a task which is still queued
+*  when the Reactor is destroyed can finish safely.
+*/
+class ReactorCore
+{
+public:
+    ReactorCore()
+        : epoll_fd(epoll_create1(EPOLL_CLOEXEC))
+        , wake_fd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+        , next_generation(0)
+    {
+        if(epoll_fd < 0 || wake_fd < 0)
+            fail("Reactor could not be created");
+
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u64 = wake_key;
+        if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event) != 0)
+            fail("Reactor could not be created");
+    }
+
+    ~ReactorCore()
+    {
+        close(wake_fd);
+        close(epoll_fd);
+    }
+
+    /**
+    * Re-arms a registration once its handler has run or its task was dropped, unless it was removed meanwhile.
+    *  An fd the handler closed without removing it is forgotten.
+    */
+    void rearm(const std::shared_ptr<ReactorRegistration>& registration)
+    {
+        std::unique_lock<std::mutex> lg(m);
+        registration->in_flight = false;
+
+        std::unordered_map<int, std::shared_ptr<ReactorRegistration>>::iterator it = registrations.find(registration->fd);
+        if(it != registrations.end() && it->second == registration && !try_arm(*registration, EPOLL_CTL_MOD))
+            registrations.erase(it);
+    }
+
+    /**
+    * Registers the fd with epoll, or changes its interest. The lock must be held.
+    */
+    void arm(ReactorRegistration& registration, int op)
+    {
+        if(!try_arm(registration, op))
+            fail("Reactor could not watch fd " + std::to_string(registration.fd));
+    }
+
+    bool try_arm(ReactorRegistration& registration, int op)
+    {
+        epoll_event event;
+        event.events = registration.events | EPOLLONESHOT;
+        event.data.u64 = key_of(registration);
+        return epoll_ctl(epoll_fd, op, registration.fd, &event) == 0;
+    }
+
+    static uint64_t key_of(const ReactorRegistration& registration)
+    {
+        return (static_cast<uint64_t>(registration.generation) << 32) | static_cast<uint32_t>(registration.fd);
+    }
+
+    static void fail(const std::string& what)
+    {
+        throw std::runtime_error(what + ": " + std::strerror(errno));
+    }
+
+    // Never the key of a registration, whose generation never reaches 0xffffffff.
+    static const uint64_t wake_key = ~static_cast<uint64_t>(0);
+
+    int epoll_fd;
+    int wake_fd;
+    std::mutex m;
+    std::unordered_map<int, std::shared_ptr<ReactorRegistration>> registrations;
+    uint32_t next_generation;
+};
+
+/**
+* Re-arms a registration once the task posted for it is gone, whether its handler ran (or threw)
+*  or the Honeydew rejected or dropped the task because a queue was full.
+*/
+struct ReactorArming
+{
+    ReactorArming(const std::shared_ptr<ReactorCore>& core, const std::shared_ptr<ReactorRegistration>& registration)
+        : core(core)
+        , registration(registration)
+    {
+    }
+
+    ~ReactorArming()
+    {
+        core->rearm(registration);
+    }
+
+    ReactorArming(const ReactorArming& other) = delete;
+    ReactorArming& operator=(const ReactorArming& other) = delete;
+
+    std::shared_ptr<ReactorCore> core;
+    std::shared_ptr<ReactorRegistration> registration;
+};
+
+}
+
+/**
+* Turns file descriptor readiness (sockets, pipes, eventfd, timerfd...) into Honeydew tasks.
+*  Each registered fd has a handler which is posted, with its own worker and priority, whenever
+*  the fd is ready. All of the readiness found by one epoll wait is posted at once, and a task
+*  for a connection's handler can run on the worker which owns the connection, without a hop
+*  through a separate reactor thread's own queue.
+*  An fd is disarmed while its handler is posted or running and re-armed when the handler
+*  returns, so handlers of one fd never run concurrently and a level triggered fd which the
+*  handler hasn't drained yet isn't posted twice. A handler task which a bounded Honeydew
+*  rejects or drops re-arms its fd too, so readiness which is still there is reported again.
+*  A Reactor is either run by its own thread (start) or polled by an existing loop (poll).
+*  Several reactors, for example one per worker, may share a Honeydew.
+*  Usage is expected to be like:
+*
+*    Reactor reactor(HONEYDEW);
+*    reactor.add(socket, EPOLLIN, [=] (uint32_t events) { read_some(socket); }, connection_worker);
+*    reactor.start();
+*/
+class Reactor
+{
+public:
+
+    /**
+    * Constructs a new reactor. Throws std::runtime_error if epoll is unavailable.
+    * @arg honeydew the Honeydew handlers are posted to.
+    * @arg max_events the largest number of ready fds taken from one epoll wait.
+    */
+    Reactor(Honeydew* honeydew, size_t max_events=64)
+        : honeydew(honeydew)
+        , core(std::make_shared<detail::ReactorCore>())
+        , ready(max_events == 0 ? 1 : max_events)
+        , stopping(false)
+    {
+    }
+
+    /**
+    * Deleted copy constructor & copy assignment
+    */
+    Reactor(const Reactor& other) = delete;
+    Reactor& operator=(const Reactor& other) = delete;
+
+    /**
+    * Stops the reactor's thread if it was started. Handlers which were already posted still run.
+    */
+    ~Reactor()
+    {
+        stop();
+    }
+
+    /**
+    * Watches an fd. Throws std::runtime_error if epoll refuses it, e.g. an fd which is already
+    *  registered or a regular file.
+    * This function is thread safe.
+    * @arg fd the file descriptor to watch. It must stay open until removed.
+    * @arg events the epoll events of interest, such as EPOLLIN | EPOLLOUT.
+    * @arg handler the function to post with the ready events whenever the fd is ready.
+    * @arg worker the worker to run the handler upon. Worker=0 means any worker.
+    * @arg priority the priority of the handler.
+    * @return a reference to this reactor for daisy chaining.
+    */
+    Reactor& add(int fd, uint32_t events, std::function<void(uint32_t)> handler, size_t worker=0, uint64_t priority=0)
+    {
+        std::shared_ptr<detail::ReactorRegistration> registration = std::make_shared<detail::ReactorRegistration>();
+        registration->fd = fd;
+        registration->events = events;
+        registration->handler = std::move(handler);
+        registration->worker = worker;
+        registration->priority = priority;
+        registration->in_flight = false;
+
+        std::unique_lock<std::mutex> lg(core->m);
+        if(core->registrations.count(fd) != 0)
+            throw std::runtime_error("Reactor already watches fd " + std::to_string(fd));
+
+        registration->generation = core->next_generation;
+        core->next_generation = (core->next_generation + 1) % 0xffffffff;
+        core->arm(*registration, EPOLL_CTL_ADD);
+        core->registrations[fd] = registration;
+        return *this;
+    }
+
+    /**
+    * Changes the events of interest of a watched fd. While its handler is posted or running the
+    *  change takes effect once the handler returns. Throws std::out_of_range if the fd isn't watched.
+    * This function is thread safe.
+    * @arg fd the watched file descriptor.
+    * @arg events the new epoll events of interest.
+    * @return a reference to this reactor for daisy chaining.
+    */
+    Reactor& modify(int fd, uint32_t events)
+    {
+        std::unique_lock<std::mutex> lg(core->m);
+        detail::ReactorRegistration& registration = *find(fd);
+        registration.events = events;
+        if(!registration.in_flight)
+            core->arm(registration, EPOLL_CTL_MOD);
+        return *this;
+    }
+
+    /**
+    * Stops watching an fd. A handler which was already posted still runs, so the fd should
+    *  only be closed by that handler or once it is known to have run.
+    * This function is thread safe.
+    * @arg fd the watched file descriptor.
+    * @return a reference to this reactor for daisy chaining.
+    */
+    Reactor& remove(int fd)
+    {
+        std::unique_lock<std::mutex> lg(core->m);
+        find(fd);
+        core->registrations.erase(fd);
+        epoll_ctl(core->epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        return *this;
+    }
+
+    /**
+    * Waits for readiness once on the calling thread and posts the handlers of the ready fds.
+    *  For a loop which is already waiting on other things, such as an application thread which
+    *  also runs an external worker: poll(0) never waits. Only one thread may poll at a time.
+    *  If the Honeydew throws while posting (FAIL policy) the exception is passed on once the
+    *  rejected fds are re-armed, while the handlers which did fit still run.
+    * @arg timeout_ms how long to wait for a ready fd in milliseconds. -1 waits indefinitely.
+    * @return the number of handlers posted.
+    */
+    size_t poll(int timeout_ms)
+    {
+        int count = epoll_wait(core->epoll_fd, &ready[0], static_cast<int>(ready.size()), timeout_ms);
+        if(count < 0)
+        {
+            if(errno == EINTR)
+                return 0;
+            detail::ReactorCore::fail("Reactor wait failed");
+        }
+
+        task_t* head = nullptr;
+        task_t* tail = nullptr;
+        size_t posted = 0;
+        {
+            std::unique_lock<std::mutex> lg(core->m);
+            for(int i=0; i < count; ++i)
+            {
+                uint64_t key = ready[i].data.u64;
+                if(key == detail::ReactorCore::wake_key)
+                {
+                    uint64_t value;
+                    while(read(core->wake_fd, &value, sizeof(value)) > 0)
+                        ;
+                    continue;
+                }
+
+                // An fd which was removed, or closed and registered again, since the wait began is skipped.
+                std::unordered_map<int, std::shared_ptr<detail::ReactorRegistration>>::iterator it =
+                    core->registrations.find(static_cast<int>(key & 0xffffffff));
+                if(it == core->registrations.end() || detail::ReactorCore::key_of(*it->second) != key)
+                    continue;
+
+                detail::ReactorRegistration& registration = *it->second;
+                registration.in_flight = true;
+                std::shared_ptr<detail::ReactorArming> arming = std::make_shared<detail::ReactorArming>(core, it->second);
+                uint32_t events = ready[i].events;
+                task_t* task = new task_t([arming, events] () {
+                    arming->registration->handler(events);
+                }, registration.worker, registration.priority);
+
+                if(head == nullptr)
+                    head = task;
+                else
+                    tail->next = task;
+                tail = task;
+                ++posted;
+            }
+        }
+
+        if(head != nullptr)
+            honeydew->post(head);
+        return posted;
+    }
+
+    /**
+    * Starts a thread which polls this reactor until stop is called. Errors are not passed on:
+    *  when the Honeydew rejects handlers, the thread yields and polls again.
+    * @return a reference to this reactor for daisy chaining.
+    */
+    Reactor& start()
+    {
+        if(thread.joinable())
+            throw std::logic_error("Reactor is already running.");
+
+        stopping = false;
+        thread = std::thread([this] () {
+            while(!stopping.load())
+            {
+                try
+                {
+                    poll(-1);
+                }
+                catch(...)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        return *this;
+    }
+
+    /**
+    * Stops and joins the thread started by start, if any. Wakes a poll which is waiting.
+    */
+    void stop()
+    {
+        stopping = true;
+        wake();
+        if(thread.joinable())
+            thread.join();
+    }
+
+    /**
+    * Makes a poll which is waiting (or the next one) return early.
+    * This function is thread safe.
+    */
+    void wake()
+    {
+        uint64_t one = 1;
+        ssize_t written = write(core->wake_fd, &one, sizeof(one));
+        (void) written;
+    }
+
+private:
+    /**
+    * Returns the registration of a watched fd. The lock must be held.
+    */
+    detail::ReactorRegistration* find(int fd)
+    {
+        std::unordered_map<int, std::shared_ptr<detail::ReactorRegistration>>::iterator it = core->registrations.find(fd);
+        if(it == core->registrations.end())
+            throw std::out_of_range("Reactor doesn't watch fd " + std::to_string(fd));
+        return it->second.get();
+    }
+
+    Honeydew* honeydew;
+    std::shared_ptr<detail::ReactorCore> core;
+    std::vector<epoll_event> ready;
+    std::atomic<bool> stopping;
+    std::thread thread;
+};
+
+}
@@ -0,0 +1,197 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+#pragma once
+
+#include <honeydew/honeydew.hpp>
+#include <honeydew/detail/queue.hpp>
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+namespace honeydew
+{
+
+/**
+* Serializes the actions posted to it: they run one at a time, in the order they were posted.
+*  Unlike pinning tasks to a worker the strand is not tied to a thread. Whenever it has work
+*  a single drain task is posted to the Honeydew which runs up to batch_size actions and then,
+*  if more are pending, re-posts itself so it can continue on whichever worker is free.
+*  A strand must outlive the actions posted to it.
+*/
+class Strand
+{
+public:
+
+    /**
+    * Constructs a new strand.
+    * @arg honeydew the Honeydew to run the strand's actions on.
+    * @arg worker the worker to run the actions on. Worker=0 (the default) lets the strand migrate.
+    * @arg priority the priority of the strand's drain task.
+    * @arg batch_size the number of actions run before the drain task is re-posted. 0 is infinite.
+    */
+    Strand(Honeydew* honeydew, size_t worker=0, uint64_t priority=0, size_t batch_size=16)
+        : honeydew(honeydew)
+        , worker(worker)
+        , priority(priority)
+        , batch_size(batch_size)
+        , pending(0)
+    {
+    }
+
+    /**
+    * Deleted copy constructor & copy assignment
+    */
+    Strand(const Strand& other) = delete;
+    Strand& operator=(const Strand& other) = delete;
+
+    /**
+    * Adds an action to the end of this strand.
+    * This function is thread safe.
+    * @arg action the function to run.
+    * @return a reference to this strand for daisy chaining.
+    */
+    Strand& post(std::function<void()> action)
+    {
+        // Counted before it is pushed, so a drain never pops an action it can't account for.
+        bool idle = pending.fetch_add(1) == 0;
+        actions.push(new task_t(action, worker, priority));
+        if(idle)
+            schedule();
+        return *this;
+    }
+
+    /**
+    * Returns a function which, when called, posts the given action to this strand.
+    *  Useful for making a stage of a Task run inside the strand.
+    * @arg action the function to run.
+    */
+    std::function<void()> wrap(std::function<void()> action)
+    {
+        Strand* self = this;
+        return [=] () { self->post(action); };
+    }
+
+private:
+
+    /**
+    * Posts the drain task. It is internal, so a bounded Honeydew never drops it.
+    */
+    void schedule()
+    {
+        task_t* task = new task_t([this] () { drain(); }, worker, priority);
+        task->internal = true;
+        honeydew->post(task);
+    }
+
+    /**
+    * Runs up to batch_size pending actions. Only one drain task exists at a time, which
+    *  is what guarantees the actions never run concurrently. An action which is counted but
+    *  not pushed yet is left to the next drain, which is posted as the count isn't 0.
+    */
+    void drain()
+    {
+        size_t ran = 0;
+        std::exception_ptr error = nullptr;
+
+        task_t* task = nullptr;
+        while((batch_size == 0 || ran < batch_size) && actions.try_pop(1, &task) != 0)
+        {
+            ++ran;
+            try
+            {
+                task->action();
+            }
+            catch(...)
+            {
+                error = std::current_exception();
+            }
+            delete task;
+
+            if(error != nullptr)
+                break;
+        }
+
+        if(pending.fetch_sub(ran) != ran)
+            schedule();
+
+        if(error != nullptr)
+            std::rethrow_exception(error);
+    }
+
+    Honeydew* honeydew;
+    size_t worker;
+    uint64_t priority;
+    size_t batch_size;
+
+    Queue<task_t> actions;
+    std::atomic<size_t> pending;
+};
+
+/**
+* A fixed set of strands selected by hashing a key. Actions posted with the same key never
+*  run concurrently and run in post order. Distinct keys which hash to the same strand are
+*  also serialized with each other, so num_strands should be well above the number of workers.
+*/
+template<typename KeyType, typename HashType=std::hash<KeyType>>
+class KeyedStrand
+{
+public:
+
+    /**
+    * Constructs num_strands strands on the given Honeydew.
+    * @arg honeydew the Honeydew to run the actions on.
+    * @arg num_strands the number of independent strands.
+    * @arg priority the priority of the strands' drain tasks.
+    */
+    KeyedStrand(Honeydew* honeydew, size_t num_strands, uint64_t priority=0)
+    {
+        strands.reserve(num_strands);
+        for(size_t i=0; i < num_strands; ++i)
+        {
+            strands.push_back(new Strand(honeydew, 0, priority));
+        }
+    }
+
+    ~KeyedStrand()
+    {
+        for(size_t i=0; i < strands.size(); ++i)
+        {
+            delete strands[i];
+        }
+    }
+
+    /**
+    * Deleted copy constructor & copy assignment
+    */
+    KeyedStrand(const KeyedStrand& other) = delete;
+    KeyedStrand& operator=(const KeyedStrand& other) = delete;
+
+    /**
+    * Adds an action to the strand of the given key.
+    * This function is thread safe.
+    * @arg key the key to serialize on.
+    * @arg action the function to run.
+    * @return a reference to this object for daisy chaining.
+    */
+    KeyedStrand& post(const KeyType& key, std::function<void()> action)
+    {
+        at(key).post(action);
+        return *this;
+    }
+
+    /**
+    * Returns the strand used for the given key.
+    */
+    Strand& at(const KeyType& key)
+    {
+        return *strands[hash(key) % strands.size()];
+    }
+
+private:
+    std::vector<Strand*> strands;
+    HashType hash;
+};
+
+}
@@ -0,0 +1,588 @@
+// This file is part of Honeydew
+// Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
+
+#pragma once
+
+#include <honeydew/honeydew.hpp>
+#include <honeydew/detail/block_pool.hpp>
+#include <honeydew/detail/mpsc_queue.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace honeydew
+{
+
+/**
+* How a stage of a StreamPipeline processes the items flowing through it.
+*/
+enum StageMode
+{
+    SERIAL_IN_ORDER,        // One item at a time, in the order the items were pushed.
+    SERIAL_OUT_OF_ORDER,    // One item at a time, in the order they reach the stage.
+    PARALLEL                // Any number of items at once.
+};
+
+namespace detail
+{
+
+/**
+* An item travelling through a StreamPipeline. value points to the output of the last stage which ran,
+*  or is nullptr once a stage has thrown, in which case the remaining stages only pass it on so
+*  ordered stages don't wait for it forever.
+*/
+struct StreamItem
+{
+    StreamItem()
+        : seq(0)
+        , value(nullptr)
+        , next(nullptr)
+    {
+    }
+
+    uint64_t seq;
+    void* value;
+    std::atomic<StreamItem*> next;
+};
+
+template<typename T>
+void destroy_stream_value(void* value)
+{
+    BlockPool::destroy(static_cast<T*>(value));
+}
+
+/**
+* A type erased stage. Serial stages receive their items through lock-free channels: an MPSC queue
+*  when order doesn't matter, or a ring of one slot per token indexed by sequence number when it does.
+*  As every item between the oldest one waiting for an ordered stage and the newest holds a token,
+*  no two of them ever share a slot.
+*/
+struct StreamStage
+{
+    StreamStage(StageMode mode, size_t worker, uint64_t priority, size_t num_slots)
+        : mode(mode)
+        , worker(worker)
+        , priority(priority)
+        , waiting(0)
+        , slots(nullptr)
+        , num_slots(num_slots)
+        , next_seq(0)
+        , draining(false)
+    {
+        if(mode == SERIAL_IN_ORDER)
+        {
+            slots = new std::atomic<StreamItem*>[num_slots];
+            for(size_t i=0; i < num_slots; ++i)
+                slots[i].store(nullptr);
+        }
+    }
+
+    virtual ~StreamStage()
+    {
+        delete[] slots;
+    }
+
+    /**
+    * Runs the stage on the given input, which it consumes.
+    * @return the boxed output, or nullptr if the stage's output is void.
+    */
+    virtual void* run(void* input) = 0;
+
+    /**
+    * Hands an item to the stage's channel. Serial stages only.
+    */
+    void arrive(StreamItem* item)
+    {
+        if(mode == SERIAL_IN_ORDER)
+        {
+            slots[item->seq % num_slots].store(item);
+        }
+        else
+        {
+            arrivals.push(item);
+            waiting.fetch_add(1);
+        }
+    }
+
+    /**
+    * Takes the next item the stage may run, if any. Only the draining thread may call this.
+    */
+    StreamItem* take()
+    {
+        if(mode == SERIAL_IN_ORDER)
+        {
+            uint64_t seq = next_seq.load(std::memory_order_relaxed);
+            std::atomic<StreamItem*>& slot = slots[seq % num_slots];
+            StreamItem* item = slot.load();
+            if(item == nullptr)
+                return nullptr;
+            slot.store(nullptr, std::memory_order_relaxed);
+            next_seq.store(seq + 1, std::memory_order_relaxed);
+            return item;
+        }
+
+        StreamItem* item = arrivals.pop();
+        if(item != nullptr)
+            waiting.fetch_sub(1);
+        return item;
+    }
+
+    /**
+    * Returns true if take() has (or is about to have) an item for the drainer.
+    */
+    bool ready() const
+    {
+        if(mode == SERIAL_IN_ORDER)
+            return slots[next_seq.load(std::memory_order_relaxed) % num_slots].load() != nullptr;
+        return waiting.load() > 0;
+    }
+
+    StageMode mode;
+    size_t worker;
+    uint64_t priority;
+
+    MpscQueue<StreamItem> arrivals;
+    std::atomic<long> waiting;
+
+    std::atomic<StreamItem*>* slots;
+    size_t num_slots;
+    std::atomic<uint64_t> next_seq;
+
+    std::atomic<bool> draining;
+};
+
+template<typename InputType, typename OutputType, typename FunctorType>
+struct StreamStageImpl : public StreamStage
+{
+    StreamStageImpl(FunctorType functor, StageMode mode, size_t worker, uint64_t priority, size_t num_slots)
+        : StreamStage(mode, worker, priority, num_slots)
+        , functor(functor)
+    {
+    }
+
+    virtual void* run(void* input)
+    {
+        InputType* in = static_cast<InputType*>(input);
+        OutputType* out;
+        try
+        {
+            out = BlockPool::create<OutputType>(functor(std::move(*in)));
+        }
+        catch(...)
+        {
+            BlockPool::destroy(in);
+            throw;
+        }
+        BlockPool::destroy(in);
+        return out;
+    }
+
+    FunctorType functor;
+};
+
+template<typename InputType, typename FunctorType>
+struct StreamStageImpl<InputType, void, FunctorType> : public StreamStage
+{
+    StreamStageImpl(FunctorType functor, StageMode mode, size_t worker, uint64_t priority, size_t num_slots)
+        : StreamStage(mode, worker, priority, num_slots)
+        , functor(functor)
+    {
+    }
+
+    virtual void* run(void* input)
+    {
+        InputType* in = static_cast<InputType*>(input);
+        try
+        {
+            functor(std::move(*in));
+        }
+        catch(...)
+        {
+            BlockPool::destroy(in);
+            throw;
+        }
+        BlockPool::destroy(in);
+        return nullptr;
+    }
+
+    FunctorType functor;
+};
+
+/**
+* The untyped state shared by every handle of a StreamPipeline.
+*  in_flight counts the items holding a token. outstanding counts those items plus the tasks
+*  the pipeline has posted, so that wait() only returns once nothing touches the pipeline anymore.
+*  Those tasks are internal, as a bounded Honeydew dropping one would leave wait() hanging.
+*/
+class StreamCore
+{
+public:
+
+    StreamCore(Honeydew* honeydew, size_t max_tokens, size_t batch_size, void (*destroy_input)(void*))
+        : honeydew(honeydew)
+        , max_tokens(max_tokens == 0 ? 1 : max_tokens)
+        , batch_size(batch_size)
+        , destroy_last(destroy_input)
+        , started(false)
+        , next_seq(0)
+        , in_flight(0)
+        , outstanding(0)
+    {
+    }
+
+    ~StreamCore()
+    {
+        wait();
+        for(size_t i=0; i < stages.size(); ++i)
+        {
+            delete stages[i];
+        }
+    }
+
+    StreamCore(const StreamCore& other) = delete;
+    StreamCore& operator=(const StreamCore& other) = delete;
+
+    /**
+    * Appends a stage. Throws std::logic_error once items were pushed, or if the stage wouldn't
+    *  follow the last one, as its input type would then not match the previous stage's output.
+    * @arg position the number of stages before the new one.
+    */
+    template<typename InputType, typename OutputType, typename FunctorType>
+    void add(FunctorType functor, StageMode mode, size_t worker, uint64_t priority, void (*destroy_output)(void*), size_t position)
+    {
+        if(started.load())
+            throw std::logic_error("Stages can't be added to a StreamPipeline which has started.");
+        if(position != stages.size())
+            throw std::logic_error("Stages can only be added after the last stage of a StreamPipeline.");
+        stages.push_back(new StreamStageImpl<InputType, OutputType, FunctorType>(functor, mode, worker, priority, max_tokens));
+        destroy_last = destroy_output;
+    }
+
+    /**
+    * Sends a boxed input into the first stage once a token is free.
+    */
+    void push(void* value)
+    {
+        started.store(true);
+        acquire_token();
+        outstanding.fetch_add(1);
+
+        StreamItem* item = BlockPool::create<StreamItem>();
+        item->seq = next_seq.fetch_add(1);
+        item->value = value;
+        deliver(0, item);
+    }
+
+    /**
+    * Blocks until every pushed item has left the pipeline. A worker keeps running tasks while it waits.
+    */
+    void wait()
+    {
+        if(honeydew->current_worker() != Honeydew::no_worker)
+        {
+            while(outstanding.load() != 0)
+            {
+                if(!honeydew->help())
+                    std::this_thread::yield();
+            }
+            // The last release notifies while holding the lock. Let it finish before returning.
+            std::unique_lock<std::mutex> lg(m);
+            return;
+        }
+
+        std::unique_lock<std::mutex> lg(m);
+        cv.wait(lg, [this] () { return outstanding.load() == 0; });
+    }
+
+private:
+
+    void acquire_token()
+    {
+        size_t count = in_flight.load();
+        while(true)
+        {
+            if(count < max_tokens)
+            {
+                if(in_flight.compare_exchange_weak(count, count + 1))
+                    return;
+                continue;
+            }
+
+            // A worker can't sleep here as it may be the one which has to move the stream along.
+            if(honeydew->current_worker() != Honeydew::no_worker)
+            {
+                if(!honeydew->help())
+                    std::this_thread::yield();
+            }
+            else
+            {
+                std::unique_lock<std::mutex> lg(m);
+                cv.wait(lg, [this] () { return in_flight.load() < max_tokens; });
+            }
+            count = in_flight.load();
+        }
+    }
+
+    void release_token()
+    {
+        if(in_flight.fetch_sub(1) == max_tokens)
+        {
+            std::unique_lock<std::mutex> lg(m);
+            cv.notify_all();
+        }
+    }
+
+    /**
+    * Drops a reference. Nothing may touch the pipeline afterwards as wait() may have returned.
+    */
+    void release()
+    {
+        size_t count = outstanding.load();
+        while(count > 1)
+        {
+            if(outstanding.compare_exchange_weak(count, count - 1))
+                return;
+        }
+
+        std::unique_lock<std::mutex> lg(m);
+        outstanding.fetch_sub(1);
+        cv.notify_all();
+    }
+
+    void deliver(size_t index, StreamItem* item)
+    {
+        if(index == stages.size())
+        {
+            finish(item);
+            return;
+        }
+
+        StreamStage* stage = stages[index];
+        if(stage->mode == PARALLEL)
+        {
+            StreamCore* self = this;
+            outstanding.fetch_add(1);
+            task_t* task = new task_t([=] () { self->run_parallel(index, item); }, stage->worker, stage->priority);
+            task->internal = true;
+            honeydew->post(task);
+            return;
+        }
+
+        stage->arrive(item);
+        if(!stage->draining.exchange(true))
+            schedule(index);
+    }
+
+    void finish(StreamItem* item)
+    {
+        if(item->value != nullptr && destroy_last != nullptr)
+            destroy_last(item->value);
+        BlockPool::destroy(item);
+        release_token();
+        release();
+    }
+
+    /**
+    * Runs a stage on an item. An exception turns the item into a placeholder and is kept in error.
+    */
+    static void run(StreamStage* stage, StreamItem* item, std::exception_ptr& error)
+    {
+        if(item->value == nullptr)
+            return;
+
+        try
+        {
+            item->value = stage->run(item->value);
+        }
+        catch(...)
+        {
+            item->value = nullptr;
+            if(error == nullptr)
+                error = std::current_exception();
+        }
+    }
+
+    void run_parallel(size_t index, StreamItem* item)
+    {
+        std::exception_ptr error = nullptr;
+        run(stages[index], item, error);
+        deliver(index + 1, item);
+        release();
+
+        if(error != nullptr)
+            std::rethrow_exception(error);
+    }
+
+    void schedule(size_t index)
+    {
+        StreamCore* self = this;
+        StreamStage* stage = stages[index];
+        outstanding.fetch_add(1);
+        task_t* task = new task_t([=] () { self->drain(index); }, stage->worker, stage->priority);
+        task->internal = true;
+        honeydew->post(task);
+    }
+
+    /**
+    * Runs up to batch_size items through a serial stage. Only one drain task per stage exists
+    *  at a time, which is what keeps the stage serial.
+    */
+    void drain(size_t index)
+    {
+        StreamStage* stage = stages[index];
+        std::exception_ptr error = nullptr;
+
+        size_t ran = 0;
+        StreamItem* item;
+        while((batch_size == 0 || ran < batch_size) && (item = stage->take()) != nullptr)
+        {
+            ++ran;
+            run(stage, item, error);
+            deliver(index + 1, item);
+        }
+
+        if(batch_size != 0 && ran == batch_size && stage->ready())
+        {
+            schedule(index);
+        }
+        else
+        {
+            // An item which arrived after the last take() but saw the stage still draining is picked up here.
+            stage->draining.store(false);
+            if(stage->ready() && !stage->draining.exchange(true))
+                schedule(index);
+        }
+        release();
+
+        if(error != nullptr)
+            std::rethrow_exception(error);
+    }
+
+    Honeydew* honeydew;
+    size_t max_tokens;
+    size_t batch_size;
+    std::vector<StreamStage*> stages;
+    void (*destroy_last)(void*);
+
+    std::atomic<bool> started;
+    std::atomic<uint64_t> next_seq;
+    std::atomic<size_t> in_flight;
+    std::atomic<size_t> outstanding;
+
+    std::mutex m;
+    std::condition_variable cv;
+};
+
+}
+
+/**
+* Processes a stream of items through a chain of stages which are declared once.
+*  Each stage is serial in order, serial out of order or parallel. Items are handed between
+*  stages through lock-free channels and the stages of different items run concurrently, so the
+*  throughput is bound by the slowest serial stage rather than by the sum of all stages.
+*  max_tokens bounds the number of items in the pipeline: push() waits (helping if it is called
+*  on a worker) until an item leaves. An item whose stage throws is dropped and the exception is
+*  rethrown to the Honeydew's exception handler.
+*  Copies of a StreamPipeline share the same stages. The last copy waits for the stream to drain
+*  when it is destroyed.
+*
+* Example:
+*   StreamPipeline<std::string> lines(honeydew, 16);
+*   auto words = lines.then(PARALLEL, [] (std::string line) { return count_words(line); })
+*                     .then(SERIAL_IN_ORDER, [&] (size_t count) { total += count; });
+*   while(std::getline(in, line))
+*       words.push(line);
+*   words.wait();
+*/
+template<typename InputType, typename OutputType=InputType>
+class StreamPipeline
+{
+    template<typename, typename>
+    friend class StreamPipeline;
+
+public:
+
+    /**
+    * Constructs a stream pipeline without any stage.
+    * @arg honeydew the Honeydew to run the stages on.
+    * @arg max_tokens the maximum number of items in the pipeline at once.
+    * @arg batch_size the number of items a serial stage runs before its task is re-posted. 0 is infinite.
+    */
+    StreamPipeline(Honeydew* honeydew, size_t max_tokens, size_t batch_size=16)
+        : core(std::make_shared<detail::StreamCore>(honeydew, max_tokens, batch_size, &detail::destroy_stream_value<InputType>))
+        , position(0)
+    {
+    }
+
+    /**
+    * Appends a stage which is given the output of the previous one (moved) and returns a handle whose
+    *  output type is the functor's return type. All stages must be added before the first push, and
+    *  only through the handle of the last stage: throws std::logic_error otherwise.
+    * @arg mode how the stage processes its items.
+    * @arg functor the function to run on each item.
+    * @arg worker the worker to run the stage on. 0 is any.
+    * @arg priority the priority of the stage's tasks.
+    */
+    template<typename FunctorType, typename T=OutputType>
+    StreamPipeline<InputType, typename std::decay<typename std::result_of<FunctorType(T&&)>::type>::type>
+    then(StageMode mode, FunctorType functor, size_t worker=0, uint64_t priority=0)
+    {
+        typedef typename std::decay<typename std::result_of<FunctorType(T&&)>::type>::type NextType;
+
+        core->template add<OutputType, NextType>(functor, mode, worker, priority, destroyer<NextType>(std::is_void<NextType>()), position);
+        return StreamPipeline<InputType, NextType>(core, position + 1);
+    }
+
+    /**
+    * Sends an item into the pipeline, waiting for a token if max_tokens items are already in it.
+    * This function is thread safe.
+    * @arg item the item to process.
+    */
+    void push(InputType item)
+    {
+        core->push(BlockPool::create<InputType>(std::move(item)));
+    }
+
+    /**
+    * Blocks until every item pushed so far has left the pipeline.
+    * This function is thread safe.
+    */
+    void wait()
+    {
+        core->wait();
+    }
+
+private:
+
+    StreamPipeline(std::shared_ptr<detail::StreamCore> core, size_t position)
+        : core(core)
+        , position(position)
+    {
+    }
+
+    template<typename T>
+    static void (*destroyer(std::false_type))(void*)
+    {
+        return &detail::destroy_stream_value<T>;
+    }
+
+    template<typename T>
+    static void (*destroyer(std::true_type))(void*)
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<detail::StreamCore> core;
+
+    // The number of stages up to and including the one whose output this handle describes.
+    size_t position;
+};
+
+}
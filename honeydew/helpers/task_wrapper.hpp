@@ -135,6 +135,25 @@ public:
     */ 
     Task& fork(task_t* other);
 
+    /**
+    * Marks the most recently added task as blocking. Instead of a worker it runs on a separate,
+    *  elastically sized pool of threads, so a task waiting on a disk read or a lock doesn't hold
+    *  up the worker's queue. Its continuations are posted to the workers as usual.
+    * @return a reference to this task for daisy chaining.
+    */
+    Task& blocking();
+
+    /**
+    * Merges each stage into the one before it when both run on the same worker with the same
+    *  priority, both or neither are blocking and neither is part of an also group, so the merged
+    *  stages cost one task_t and one trip through a queue. A stage with forks of its own, or which
+    *  starts a fiber, is kept separate.
+    *  The stages still run in order and a throwing stage doesn't stop the ones after it: once all
+    *  of a merged task's stages have run, each exception reaches the exception handler in stage order.
+    * @return a reference to this task for daisy chaining.
+    */
+    Task& fuse();
+
     /**
     * Returns the associated task_t* of this object and then !empties this object!
     *  This function is intended to be used by the Honeydew implementing classes ONLY!
@@ -2,55 +2,80 @@
 // Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
 #pragma once
 
-#include <honeydew/helpers/task_wrapper.hpp>
+#include <honeydew/honeydew.hpp>
+#include <honeydew/detail/timing_wheel.hpp>
 
-#include <queue>
+#include <chrono>
+#include <exception>
 #include <functional>
-#include <atomic>
 #include <thread>
 #include <mutex>
-
-#include <iostream>
+#include <condition_variable>
+#include <vector>
+#include <limits>
 
 namespace honeydew
 {
+
+/**
+* Identifies a task scheduled on a Timer so it can be cancelled.
+*/
+typedef uint64_t TimerId;
+
 namespace detail
 {
 
-struct TimerTask
+struct TimerTask : public TimingWheelNode
 {
-    TimerTask(std::function<bool()> functor, size_t worker, uint64_t priority, uint64_t period, uint64_t next_time)
-        : functor(functor)
-        , worker(worker)
-        , priority(priority)
-        , period(period)
-        , next_time(next_time)
+    enum State
+    {
+        SCHEDULED,
+        RUNNING,
+        CANCELLED
+    };
+
+    TimerTask(uint32_t index)
+        : worker(0)
+        , priority(0)
+        , period(0)
+        , slack(0)
+        , index(index)
+        , generation(0)
+        , state(SCHEDULED)
     {
     }
 
+    TimerId id() const
+    {
+        return (static_cast<uint64_t>(generation) << 32) | index;
+    }
+
     std::function<bool()> functor;
     size_t worker;
     uint64_t priority;
     uint64_t period;
-    uint64_t next_time;
-};
-
-struct TimerComp
-{
-    bool operator() (const detail::TimerTask& lhs, const detail::TimerTask& rhs) const
-    {
-    return lhs.next_time < rhs.next_time;
-    }
+    uint64_t slack;
+    uint32_t index;
+    uint32_t generation;
+    State state;
 };
 
 }
 
 /**
 * A helper class that allows for the posting of tasks to a given Honeydew.
-*  timer_period is the time in DurationType around which the timer thread will check
-*  the queue of TimerTasks.
+*  timer_period is the resolution of the timer in DurationType units. Pending tasks are kept in
+*  a hierarchical timing wheel with one slot per timer_period, so scheduling and cancelling cost
+*  O(1) no matter how many tasks are pending. The timer thread sleeps on a monotonic clock until
+*  the next expiry instead of polling.
+*  Tasks given a slack may fire up to that much later than their period so that expirations of
+*  many similar timers land on the same tick. Everything due on a tick is posted in one batch
+*  with a single task per target worker and priority. Those tasks are internal (task_t::internal):
+*  a bounded Honeydew always queues them, so a full queue under any overflow policy neither throws
+*  on the timer thread nor loses a periodic task.
 *  DurationType is a std::chrono type (such as std::chrono::milliseconds) which defines the
 *  units of the periods given to this timer.
+*  A timer must outlive the tasks it has posted.
 */
 template<uint64_t timer_period, typename DurationType=std::chrono::milliseconds>
 class Timer
@@ -62,12 +87,13 @@ public:
     */
     Timer(Honeydew* honeydew)
         : honeydew(honeydew)
+        , start(std::chrono::steady_clock::now())
+        , wheel(0)
+        , wake_tick(0)
+        , running(true)
     {
-        // Initialize to 1.
-        running.test_and_set();
-
         // Start a timer thread.
-        timer_thread = std::thread(std::bind(&Timer<timer_period>::run, this));
+        timer_thread = std::thread(std::bind(&Timer::run, this));
     }
 
     /**
@@ -77,75 +103,308 @@ public:
     Timer& operator=(const Timer& other) = delete;
 
     /**
-    * Default move construction & assignment.
+    * Shuts the timer down if shutdown() was not called and releases all pending tasks.
     */
-    Timer(Timer&& other) = default;
-    Timer& operator=(Timer&& other) = default;
-   
+    ~Timer()
+    {
+        if(timer_thread.joinable())
+            shutdown();
+
+        for(size_t i=0; i < tasks.size(); ++i)
+        {
+            delete tasks[i];
+        }
+    }
+
     /**
     * Schedules a new task into this timer.
+    * This function is thread safe.
     * @arg functor the functor to run. If it returns true this task will be rescheduled at time [current_time] + period
     * @arg period the period of the task given in DurationType units.
     * @arg worker the worker thread to run the functor upon.
     * @arg priority the priority of the timed task.
+    * @arg slack how much later than period (in DurationType units) the task may run, allowing it to share a wake-up with other tasks.
+    * @return an id which can be given to cancel().
     */
-    void schedule(std::function<bool()> functor, uint64_t period, size_t worker=0, uint64_t priority=0)
+    TimerId schedule(std::function<bool()> functor, uint64_t period, size_t worker=0, uint64_t priority=0, uint64_t slack=0)
     {
         std::unique_lock<std::mutex> lg(mut);
-        queue.emplace(functor, worker, priority, period, current_time_nanos() + period);
+        detail::TimerTask* task = allocate();
+        task->functor = functor;
+        task->period = (period + timer_period - 1) / timer_period;
+        if(task->period == 0)
+            task->period = 1;
+        task->slack = slack / timer_period;
+        task->worker = worker;
+        task->priority = priority;
+        insert(task, current_tick() + task->period);
+        return task->id();
     }
 
     /**
-    * Attempts to shutdown this timer by setting an atomic flag
+    * Cancels a scheduled task. If the task has already been posted it will not run unless its
+    *  batch has started, and will not be rescheduled.
+    * This function is thread safe.
+    * @arg id the id returned by schedule().
+    * @return true if the task was pending, false if it had already finished or been cancelled.
+    */
+    bool cancel(TimerId id)
+    {
+        std::unique_lock<std::mutex> lg(mut);
+        uint32_t index = static_cast<uint32_t>(id);
+        if(index >= tasks.size() || tasks[index]->id() != id)
+            return false;
+
+        detail::TimerTask* task = tasks[index];
+        switch(task->state)
+        {
+        case detail::TimerTask::SCHEDULED:
+            wheel.remove(task);
+            release(task);
+            return true;
+        case detail::TimerTask::RUNNING:
+            task->state = detail::TimerTask::CANCELLED;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    /**
+    * Attempts to shutdown this timer by clearing the running flag
     *  and then joining on the timer thread. This method blocks
     *  until the timer thread has finished executing.
     */
     void shutdown()
     {
-        running.clear();
+        {
+            std::unique_lock<std::mutex> lg(mut);
+            running = false;
+        }
+        cv.notify_all();
         timer_thread.join();
     }
 
 private:
-    typedef std::priority_queue<detail::TimerTask, std::vector<detail::TimerTask>, detail::TimerComp> QueueType;
-    
-    static uint64_t current_time_nanos()
+
+    uint64_t current_tick() const
+    {
+        return std::chrono::duration_cast<DurationType>(std::chrono::steady_clock::now() - start).count() / timer_period;
+    }
+
+    std::chrono::steady_clock::time_point time_of(uint64_t tick) const
+    {
+        return start + DurationType(tick * timer_period);
+    }
+
+    /**
+    * Returns an unused task slot. The lock must be held.
+    */
+    detail::TimerTask* allocate()
+    {
+        if(free_tasks.empty())
+        {
+            tasks.push_back(new detail::TimerTask(static_cast<uint32_t>(tasks.size())));
+            return tasks.back();
+        }
+
+        detail::TimerTask* task = tasks[free_tasks.back()];
+        free_tasks.pop_back();
+        task->state = detail::TimerTask::SCHEDULED;
+        return task;
+    }
+
+    /**
+    * Returns a task slot for reuse. Bumping the generation invalidates its old id. The lock must be held.
+    */
+    void release(detail::TimerTask* task)
+    {
+        ++task->generation;
+        task->state = detail::TimerTask::CANCELLED;
+        task->functor = nullptr;
+        free_tasks.push_back(task->index);
+    }
+
+    /**
+    * Inserts the task into the wheel and wakes the timer thread if it now has to wake earlier.
+    *  The lock must be held.
+    */
+    void insert(detail::TimerTask* task, uint64_t expiry)
+    {
+        // Round up to the largest power of two within the slack so that timers with
+        //   similar deadlines share a tick.
+        if(task->slack > 0)
+        {
+            uint64_t granularity = 1;
+            while(granularity <= task->slack / 2)
+                granularity *= 2;
+            expiry = (expiry + granularity - 1) & ~(granularity - 1);
+        }
+
+        task->expiry = expiry;
+        task->state = detail::TimerTask::SCHEDULED;
+        wheel.insert(task);
+        if(expiry < wake_tick)
+            cv.notify_all();
+    }
+
+    /**
+    * Runs a batch of fired tasks which share a worker and priority.
+    */
+    void fire(const std::vector<detail::TimerTask*>& batch)
     {
-        return std::chrono::duration_cast<DurationType>(std::chrono::system_clock::now().time_since_epoch()).count();
+        // Drop the tasks which were cancelled while waiting to run.
+        std::vector<detail::TimerTask*> ready;
+        ready.reserve(batch.size());
+        {
+            std::unique_lock<std::mutex> lg(mut);
+            for(size_t i=0; i < batch.size(); ++i)
+            {
+                if(batch[i]->state == detail::TimerTask::CANCELLED)
+                    release(batch[i]);
+                else
+                    ready.push_back(batch[i]);
+            }
+        }
+
+        // One throwing functor must not keep the rest of the batch from running.
+        std::exception_ptr error = nullptr;
+        std::vector<bool> reschedule(ready.size(), false);
+        for(size_t i=0; i < ready.size(); ++i)
+        {
+            try
+            {
+                reschedule[i] = ready[i]->functor();
+            }
+            catch(...)
+            {
+                if(error == nullptr)
+                    error = std::current_exception();
+            }
+        }
+
+        {
+            std::unique_lock<std::mutex> lg(mut);
+            for(size_t i=0; i < ready.size(); ++i)
+            {
+                if(reschedule[i] && running && ready[i]->state == detail::TimerTask::RUNNING)
+                    insert(ready[i], current_tick() + ready[i]->period);
+                else
+                    release(ready[i]);
+            }
+        }
+
+        if(error != nullptr)
+            std::rethrow_exception(error);
     }
-    
+
+    /**
+    * Groups the expired tasks into one task_t per target worker and priority. Tasks which may run
+    *  on any worker are spread over num_workers() groups so they still run in parallel.
+    *  The lock must be held.
+    */
+    task_t* group(std::vector<detail::TimerTask*>& expired)
+    {
+        struct Group
+        {
+            size_t worker;
+            uint64_t priority;
+            size_t lane;
+            std::vector<detail::TimerTask*> batch;
+        };
+
+        std::vector<Group> groups;
+        size_t spread = 0;
+        for(size_t i=0; i < expired.size(); ++i)
+        {
+            detail::TimerTask* task = expired[i];
+            size_t lane = task->worker == 0 ? spread++ % honeydew->num_workers() : 0;
+
+            size_t g = 0;
+            while(g < groups.size() && (groups[g].worker != task->worker || groups[g].priority != task->priority || groups[g].lane != lane))
+                ++g;
+
+            if(g == groups.size())
+            {
+                groups.push_back(Group());
+                groups.back().worker = task->worker;
+                groups.back().priority = task->priority;
+                groups.back().lane = lane;
+            }
+            groups[g].batch.push_back(task);
+        }
+        expired.clear();
+
+        Timer* self = this;
+        task_t* result = nullptr;
+        for(size_t g=0; g < groups.size(); ++g)
+        {
+            std::vector<detail::TimerTask*> batch;
+            batch.swap(groups[g].batch);
+            task_t* t = new task_t([=] () { self->fire(batch); }, groups[g].worker, groups[g].priority);
+            t->internal = true;
+            t->next = result;
+            result = t;
+        }
+        return result;
+    }
+
     void run()
     {
-        while(running.test_and_set())
+        std::unique_lock<std::mutex> lg(mut);
+        while(running)
         {
+            // Gather every expired task into a single list which is posted at once.
+            wheel.advance(current_tick(), [&] (TimingWheelNode* node) {
+                detail::TimerTask* task = static_cast<detail::TimerTask*>(node);
+                task->state = detail::TimerTask::RUNNING;
+                expired.push_back(task);
+            });
+
+            if(!expired.empty())
             {
-                std::unique_lock<std::mutex> lg(mut);
-                uint64_t current_time = current_time_nanos();
-                
-                while(!queue.empty() && queue.top().next_time <= current_time)
+                task_t* batch = group(expired);
+                lg.unlock();
+                try
                 {
-                    detail::TimerTask top = queue.top();
-                    honeydew->post(Task([=]() {
-                        if(top.functor())
-                        {
-                            // Reschedule in the timer.
-                            this->schedule(top.functor, top.period, top.worker, top.priority);
-                        }                        
-                    }, top.worker, top.priority));
-                    queue.pop();
+                    honeydew->post(batch);
                 }
+                catch(...)
+                {
+                    // The overflow policy never rejects the internal batch. Whatever else went
+                    //  wrong must not terminate the timer thread.
+                }
+                lg.lock();
+                continue;
             }
 
-            std::this_thread::sleep_for(DurationType(timer_period));
+            uint64_t next_tick;
+            if(wheel.next_tick(&next_tick))
+            {
+                wake_tick = next_tick;
+                cv.wait_until(lg, time_of(next_tick));
+            }
+            else
+            {
+                wake_tick = std::numeric_limits<uint64_t>::max();
+                cv.wait(lg);
+            }
         }
     }
 
     Honeydew* honeydew;
+    std::chrono::steady_clock::time_point start;
     std::thread timer_thread;
-    std::atomic_flag running;
 
     std::mutex mut;
-    QueueType queue;
+    std::condition_variable cv;
+    TimingWheel wheel;
+    uint64_t wake_tick;
+    bool running;
+
+    std::vector<detail::TimerTask*> tasks;
+    std::vector<uint32_t> free_tasks;
+    std::vector<detail::TimerTask*> expired;
 };
 
 }
@@ -5,6 +5,10 @@
 
 #include <honeydew/task_t.hpp>
 
+#include <chrono>
+#include <string>
+#include <vector>
+
 namespace honeydew {
 
 /**
@@ -18,9 +22,71 @@ struct Honeydew
         ROUND_ROBIN,
         ROUND_ROBIN_WITH_PRIORITY,
         LEAST_BUSY,
-        LEAST_BUSY_WITH_PRIORITY
+        LEAST_BUSY_WITH_PRIORITY,
+        THREAD_PER_CORE         // Shared-nothing workers linked by lock-free rings. Tasks run in the order they arrive.
+    };
+
+    /**
+    * What happens when a task is posted to a worker whose queue is at capacity.
+    *  Dropped tasks are deleted without running, and so is their continuation unless
+    *  it is shared with other tasks (Task::also) which have not completed yet.
+    *  Internal tasks (task_t::internal), which the scheduler and its helpers use for their own
+    *  bookkeeping such as timer hand-overs and strand, stream and parallel loop tasks, are exempt:
+    *  they are always queued and never dropped.
+    */
+    enum OverflowPolicy
+    {
+        BLOCK,                  // post waits for room. A worker keeps running its own tasks while it waits.
+        FAIL,                   // post throws std::overflow_error. The task is deleted.
+        DROP_OLDEST,            // The oldest task in the queue is dropped to make room. The *_WITH_PRIORITY types
+                                //   keep no age, so there this acts as DROP_LOWEST_PRIORITY.
+        DROP_LOWEST_PRIORITY    // The task with the largest priority value, queued or new, is dropped to make room.
+    };
+
+    /**
+    * Value returned by current_worker() when the calling thread is not a worker.
+    */
+    static const size_t no_worker = static_cast<size_t>(-1);
+
+    /**
+    * Set in the worker ids returned by group(). Such an id means any worker of the group.
+    */
+    static const size_t group_bit = static_cast<size_t>(1) << (sizeof(size_t) * 8 - 1);
+
+    /**
+    * Describes a named pool of workers for create(groups). Each group has its own queue
+    *  type and placement policy.
+    */
+    struct WorkerGroup
+    {
+        WorkerGroup(const std::string& name, size_t num_threads, HoneydewType type=ROUND_ROBIN, size_t step_size=1, size_t capacity=0, OverflowPolicy policy=BLOCK, bool external=false)
+            : name(name)
+            , num_threads(num_threads)
+            , type(type)
+            , step_size(step_size)
+            , capacity(capacity)
+            , policy(policy)
+            , external(external)
+        {
+        }
+
+        std::string name;
+        size_t num_threads;
+        HoneydewType type;
+        size_t step_size;
+        size_t capacity;
+        OverflowPolicy policy;
+
+        // The workers of an external group get no threads. Application threads run them with
+        //   run_one, poll and run_for, e.g. from the main thread or an existing event loop.
+        bool external;
     };
 
+    /**
+    * The granularity of the timers used by post_at and post_after.
+    */
+    typedef std::chrono::milliseconds timer_resolution;
+
     virtual ~Honeydew() {}
 
     /**
@@ -29,8 +95,26 @@ struct Honeydew
     * @param num_threads the number of workers to create. This affects the number of independent work queues.
     *                       if the number of resources > num_threads some resources will share a thread.
     * @param step_size the maximum number of events each worker removes from the queue at a time. 0 is infinite.
+    * @param capacity the maximum number of tasks queued per worker. 0 (the default) is unbounded.
+    * @param policy what to do when a task is posted to a full queue.
+    *
+    * A THREAD_PER_CORE Honeydew posts without locks: each pair of workers shares a single producer
+    *  single consumer ring and other threads use an injection ring per worker. There capacity is the
+    *  size of each ring (0 means 1024), a worker whose ring to another worker is full keeps the
+    *  extra tasks itself until there is room, and a task for worker 0 stays on the worker posting
+    *  it. Other threads wait for room in a full injection ring, or throw under the FAIL policy.
     */
-    static Honeydew* create(HoneydewType type, size_t num_threads, size_t step_size);
+    static Honeydew* create(HoneydewType type, size_t num_threads, size_t step_size, size_t capacity=0, OverflowPolicy policy=BLOCK);
+
+    /**
+    * Creates a new Honeydew made of several worker groups, such as a few I/O workers next to
+    *  many compute workers, so that the tasks of one group never wait behind those of another.
+    *  Workers are numbered across the groups in the order given: the first group owns workers
+    *  1 to n1, the second n1+1 to n1+n2, and so on. Worker 0 means any worker of the first group
+    *  and group(name) returns an id meaning any worker of that group.
+    * @param groups the groups to create. Names must be unique.
+    */
+    static Honeydew* create(const std::vector<WorkerGroup>& groups);
 
     /**
     * Schedules the given task's task_t* sub-object
@@ -53,6 +137,71 @@ struct Honeydew
     */
     virtual Honeydew* post(task_t* t) = 0;
 
+    /**
+    * Schedules the given task's task_t* sub-object without blocking.
+    * This function is thread safe.
+    *
+    * @param t the task to schedule.
+    * @return false if any of its task_t objects were rejected.
+    */
+    template<typename TaskType>
+    bool try_post(TaskType&& t)
+    {
+        return try_post(t.close());
+    }
+
+    /**
+    * Schedules a properly built task_t* object without blocking. When a queue is full the
+    *  DROP_ policies make room as usual while BLOCK and FAIL reject the task, which is deleted.
+    * This function is thread safe.
+    *
+    * @param t the task_t* to schedule.
+    * @return false if any task_t was rejected.
+    */
+    virtual bool try_post(task_t* t) = 0;
+
+    /**
+    * Schedules the given task's task_t* sub-object to be posted at the given time.
+    * This function is thread safe.
+    *
+    * @param t the task to schedule.
+    * @param time the earliest time at which the task may run.
+    */
+    template<typename TaskType>
+    Honeydew* post_at(TaskType&& t, std::chrono::steady_clock::time_point time)
+    {
+        post_at(t.close(), time);
+        return this;
+    }
+
+    /**
+    * Schedules a properly built task_t* object to be posted at the given time.
+    *  The timed task is kept by a worker (the calling one if it is a worker) which checks
+    *  its timers between batches, so no extra thread is involved.
+    *  Times are rounded up to the scheduler's timer_resolution.
+    *  Bounded queues apply their overflow policy when the timer fires. Handing the timer over to
+    *  a worker is an internal task, which the policy never rejects or drops.
+    * This function is thread safe.
+    *
+    * @param t the task_t* to schedule.
+    * @param time the earliest time at which the task may run.
+    */
+    virtual Honeydew* post_at(task_t* t, std::chrono::steady_clock::time_point time) = 0;
+
+    /**
+    * Schedules the given task (or task_t*) to be posted once the given delay has elapsed.
+    * This function is thread safe.
+    *
+    * @param t the task to schedule.
+    * @param delay a std::chrono duration to wait before posting the task.
+    */
+    template<typename TaskType, typename Rep, typename Period>
+    Honeydew* post_after(TaskType&& t, std::chrono::duration<Rep, Period> delay)
+    {
+        return post_at(std::forward<TaskType>(t), std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay));
+    }
+
     /**
     * Sets a function to be posted when an exception is caught by the Honeydew.
     * This function is not thread safe.
@@ -62,6 +211,103 @@ struct Honeydew
     * @arg priority the priority of the worker handling the exception.
     */
     virtual Honeydew* set_exception_handler(std::function<void(std::exception_ptr)> handler, size_t worker=0, uint64_t priority=0) = 0; 
+
+    /**
+    * Sets the limits of the pool which runs blocking tasks (see Task::blocking). The pool starts
+    *  a thread whenever a blocking task arrives and all of its threads are busy, up to max_threads,
+    *  and a thread which has been idle for keep_alive exits. The defaults are 64 threads and 10 seconds.
+    * This function is thread safe.
+    *
+    * @arg max_threads the largest number of threads running blocking tasks at once.
+    * @arg keep_alive how long an idle pool thread waits for work before exiting.
+    */
+    virtual Honeydew* set_blocking_pool(size_t max_threads, std::chrono::milliseconds keep_alive=std::chrono::seconds(10)) = 0;
+
+    /**
+    * Returns the number of workers (and therefore independent work queues) in this Honeydew.
+    */
+    virtual size_t num_workers() const = 0;
+
+    /**
+    * Returns the worker id which targets any worker of the named group. Posting a task with
+    *  this id places it with the group's own policy. Throws std::out_of_range for an unknown group.
+    * This function is thread safe.
+    * @arg name the name of the group.
+    */
+    virtual size_t group(const std::string& name) const = 0;
+
+    /**
+    * Returns the index [0, num_workers()) of the worker running on the calling thread,
+    *  or no_worker if the calling thread is not one of this Honeydew's workers.
+    * This function is thread safe.
+    */
+    virtual size_t current_worker() const = 0;
+
+    /**
+    * Returns the worker id which targets the worker running on the calling thread, so a task
+    *  posted with it runs on that same thread. Returns 0 (any worker) if the calling thread
+    *  is not one of this Honeydew's workers.
+    * This function is thread safe.
+    */
+    virtual size_t current_worker_id() const = 0;
+
+    /**
+    * Runs tasks of an external worker (see WorkerGroup::external) on the calling thread until
+    *  max_tasks have run, or no task is ready once the deadline has passed. Meanwhile the calling
+    *  thread is that worker: current_worker(), help(), timers and tasks posted to the worker
+    *  all behave as they do on a worker's own thread. Throws std::logic_error if the worker has a
+    *  thread of its own or another thread is running it, std::out_of_range for worker 0 or a group id.
+    * This function is thread safe.
+    *
+    * @arg worker the id of the worker to run.
+    * @arg max_tasks the number of tasks to run at most. 0 is unlimited.
+    * @arg deadline the time until which to wait for tasks. time_point::max() waits indefinitely.
+    * @return the number of tasks run.
+    */
+    virtual size_t run_worker(size_t worker, size_t max_tasks, std::chrono::steady_clock::time_point deadline) = 0;
+
+    /**
+    * Waits for a task of the given external worker and runs it on the calling thread.
+    * @arg worker the id of the worker to run.
+    * @return the number of tasks run (1).
+    */
+    size_t run_one(size_t worker)
+    {
+        return run_worker(worker, 1, std::chrono::steady_clock::time_point::max());
+    }
+
+    /**
+    * Runs the ready tasks of the given external worker on the calling thread without waiting,
+    *  including those which become ready while it runs.
+    * @arg worker the id of the worker to run.
+    * @return the number of tasks run.
+    */
+    size_t poll(size_t worker)
+    {
+        return run_worker(worker, 0, std::chrono::steady_clock::time_point::min());
+    }
+
+    /**
+    * Runs the tasks of the given external worker on the calling thread as they become ready
+    *  until the given duration has elapsed.
+    * @arg worker the id of the worker to run.
+    * @arg duration a std::chrono duration to run for.
+    * @return the number of tasks run.
+    */
+    template<typename Rep, typename Period>
+    size_t run_for(size_t worker, std::chrono::duration<Rep, Period> duration)
+    {
+        return run_worker(worker, 0, std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration));
+    }
+
+    /**
+    * Runs a single ready task from the calling worker's queue without blocking.
+    *  Used by threads that have to wait on other tasks so their worker keeps making progress.
+    * This function is thread safe.
+    * @return true if a task was run. false if no task was ready or the calling thread is not a worker.
+    */
+    virtual bool help() = 0;
 };
 
 }
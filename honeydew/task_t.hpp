@@ -30,6 +30,25 @@ struct task_t
     join_semaphore_t* join;
     size_t worker;
 
+    // Persistent tasks belong to a reusable construct (see helpers/loop_task.hpp) which reposts
+    //   and eventually frees them. The scheduler never deletes them.
+    bool persistent;
+
+    // Blocking tasks run on the Honeydew's blocking pool instead of a worker (see Task::blocking).
+    bool blocking;
+
+    // Internal tasks carry the bookkeeping of the scheduler and its helpers (timer hand-overs,
+    //   strand and stream drains...). Bounded queues always take them and never evict them.
+    bool internal;
+
+    // Tasks whose action refers to the task itself, like the start of a fiber, are never merged
+    //   with another (see Task::fuse).
+    bool fusable;
+
+    // Called when the task is discarded instead of run (see Honeydew::OverflowPolicy), before it is
+    //   deleted. Lets the owner of a persistent task tear down what the task belongs to.
+    std::function<void()> on_discard;
+
     task_t *next;
 };
 
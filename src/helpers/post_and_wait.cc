@@ -2,25 +2,15 @@
 // Honeydew is licensed under the MIT LICENSE. See the LICENSE file for more info.
 
 #include <honeydew/helpers/post_and_wait.hpp>
+#include <honeydew/detail/wait_flag.hpp>
 
-#include <mutex>
-#include <condition_variable>
-
-void honeydew::post_and_wait(Honeydew* honeydew, Task& task)
+void honeydew::post_and_wait(Honeydew* honeydew, Task& task, size_t spin_count)
 {
-    std::mutex mut;
-    std::condition_variable cv;
-    bool complete = false;
+    WaitFlag complete;
 
     honeydew->post(task.then([&] () {
-        {
-            std::unique_lock<std::mutex> lg(mut);
-            complete = true;
-        }
-        cv.notify_all();
+        complete.set();
     }));
 
-    std::unique_lock<std::mutex> lg(mut);
-    while(!complete)
-        cv.wait(lg);    
+    complete.wait(honeydew, spin_count);
 }
@@ -3,9 +3,83 @@
 
 #include <honeydew/helpers/task_wrapper.hpp>
 #include <honeydew/detail/join_semaphore.hpp>
+#include <honeydew/detail/stage_errors.hpp>
+
+#include <exception>
+#include <unordered_set>
+#include <vector>
 
 using namespace honeydew;
 
+/**
+* The action of a task_t made by fusing consecutive stages.
+*/
+struct FusedStages
+{
+    void operator()() const
+    {
+        StageErrors errors;
+        for(size_t i=0; i < stages.size(); ++i)
+        {
+            try
+            {
+                stages[i]();
+            }
+            catch(...)
+            {
+                errors.errors.push_back(std::current_exception());
+            }
+        }
+
+        // A single exception is passed on as is, as if the stage had run on its own.
+        if(errors.errors.size() == 1)
+            std::rethrow_exception(errors.errors[0]);
+        if(!errors.errors.empty())
+            throw errors;
+    }
+
+    std::vector<std::function<void()>> stages;
+};
+
+/**
+* Returns true if next only waits for task and may run right after it on the same thread.
+*/
+static bool can_fuse(const task_t* task, const task_t* next)
+{
+    return task->join == nullptr
+        && next->join == nullptr
+        && next->next == nullptr
+        && next->worker == task->worker
+        && next->priority == task->priority
+        && next->blocking == task->blocking
+        && task->fusable
+        && next->fusable;
+}
+
+/**
+* Folds the chain of fusable continuations of task into it.
+*  leaf is moved to task if it is one of the folded tasks.
+*/
+static void fuse_continuations(task_t* task, task_t*& leaf)
+{
+    if(task->continuation == nullptr || !can_fuse(task, task->continuation))
+        return;
+
+    FusedStages fused;
+    fused.stages.push_back(std::move(task->action));
+    while(task->continuation != nullptr && can_fuse(task, task->continuation))
+    {
+        task_t* next = task->continuation;
+        fused.stages.push_back(std::move(next->action));
+        task->continuation = next->continuation;
+        next->continuation = nullptr;
+        if(leaf == next)
+            leaf = task;
+        delete next;
+    }
+    task->action = fused;
+}
+
 Task::Task()
     : root(nullptr)
     , or_root(nullptr)
@@ -164,6 +238,38 @@ Task& Task::fork(task_t* other)
     return *this;
 }
 
+Task& Task::blocking()
+{
+    leaf->blocking = true;
+    return *this;
+}
+
+Task& Task::fuse()
+{
+    // Walk each level (a list of tasks posted together) once. The members of an also group share
+    //   their continuation, which is why levels are remembered.
+    std::vector<task_t*> levels;
+    std::unordered_set<task_t*> seen;
+    if(root != nullptr)
+        levels.push_back(root);
+
+    while(!levels.empty())
+    {
+        task_t* level = levels.back();
+        levels.pop_back();
+        if(!seen.insert(level).second)
+            continue;
+
+        for(task_t* task = level; task != nullptr; task = task->next)
+        {
+            fuse_continuations(task, leaf);
+            if(task->continuation != nullptr)
+                levels.push_back(task->continuation);
+        }
+    }
+    return *this;
+}
+
 task_t* Task::close()
 {
     task_t* result = root;
@@ -6,152 +6,1355 @@
 #include <honeydew/detail/binary_min_heap.hpp>
 #include <honeydew/detail/counting_wrapper.hpp>
 #include <honeydew/detail/join_semaphore.hpp>
+#include <honeydew/detail/timing_wheel.hpp>
+#include <honeydew/detail/blocking_pool.hpp>
+#include <honeydew/detail/spsc_ring.hpp>
+#include <honeydew/detail/mpsc_ring.hpp>
+#include <honeydew/detail/stage_errors.hpp>
 
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 #include <vector>
+#include <string>
+#include <stdexcept>
 
 using namespace honeydew;
 
+const size_t Honeydew::no_worker;
+const size_t Honeydew::group_bit;
+
+/**
+* Identifies the Honeydew and queue index owned by the calling thread (if any).
+*/
+static thread_local const Honeydew* current_honeydew = nullptr;
+static thread_local size_t current_index = Honeydew::no_worker;
+
+/**
+* The remainder of the batch of tasks the calling worker removed from its queue.
+*  Kept outside of run() so tasks which wait (and therefore help) can reach it.
+*/
+static thread_local task_t* current_batch = nullptr;
+
+/**
+* A task waiting in a worker's timing wheel to be posted.
+*/
+struct TimedTask : public TimingWheelNode
+{
+    TimedTask(task_t* task, uint64_t expiry)
+        : task(task)
+    {
+        this->expiry = expiry;
+    }
+
+    task_t* task;
+};
+
+/**
+* Makes the calling thread act as one of a Honeydew's workers while it exists (see Honeydew::run_worker).
+*  Whatever the thread was before is put back afterwards, as an application thread may run a
+*  worker from inside a task of another Honeydew.
+*/
+struct WorkerScope
+{
+    WorkerScope(const Honeydew* honeydew, size_t index, std::atomic<bool>& running)
+        : running(running)
+    {
+        if(running.exchange(true))
+            throw std::logic_error("Honeydew worker is already being run by another thread.");
+
+        previous_honeydew = current_honeydew;
+        previous_index = current_index;
+        previous_batch = current_batch;
+        current_honeydew = honeydew;
+        current_index = index;
+        current_batch = nullptr;
+    }
+
+    ~WorkerScope()
+    {
+        current_honeydew = previous_honeydew;
+        current_index = previous_index;
+        current_batch = previous_batch;
+        running.store(false);
+    }
+
+    std::atomic<bool>& running;
+    const Honeydew* previous_honeydew;
+    size_t previous_index;
+    task_t* previous_batch;
+};
+
+/**
+* Implemented by a Honeydew made of worker groups. The groups hand it the tasks they generate
+*  themselves (continuations, timed tasks, exception handlers) so each reaches the group it targets.
+*/
+struct Router
+{
+    virtual ~Router() {}
+    virtual void post_internal(task_t* task) = 0;
+};
+
+/**
+* A set of workers sharing a queue type and placement policy: a whole Honeydew, or one group of one.
+*/
+struct WorkerGroupBase : public Honeydew
+{
+    /**
+    * @arg router the Honeydew this is a group of, or nullptr if it stands alone.
+    */
+    WorkerGroupBase(Router* router)
+        : exception_handler(nullptr)
+        , exception_worker(0)
+        , exception_priority(0)
+        , timer_start(std::chrono::steady_clock::now())
+        , router(router)
+    {
+    }
+
+    /**
+    * Posts tasks the scheduler generated, which are known to target this group. Never throws.
+    */
+    virtual void post_local_internal(task_t* task) = 0;
+
+    /**
+    * Posts the tasks the scheduler generates itself (continuations, timed tasks, exception handlers).
+    *  These never throw: under the FAIL policy a task which doesn't fit is dropped.
+    */
+    void post_internal(task_t* task)
+    {
+        if(router != nullptr)
+            router->post_internal(task);
+        else
+            post_local_internal(task);
+    }
+
+    /**
+    * Runs the given task, posts its continuation if it is the last of its join,
+    *  and deletes it.
+    */
+    void execute(task_t* task)
+    {
+        try
+        {
+            task->action();
+        }
+        catch(StageErrors& errors)
+        {
+            if(exception_handler != nullptr)
+                for(std::exception_ptr e : errors.errors)
+                    post_internal(new task_t([=]() {exception_handler(e);}, exception_worker, exception_priority));
+        }
+        catch(...)
+        {
+            if(exception_handler != nullptr)
+            {
+                std::exception_ptr e = std::current_exception();
+                post_internal(new task_t([=]() {exception_handler(e);}, exception_worker, exception_priority));
+            }
+        }
+
+        // The owner of a persistent task may free it as soon as its continuation is posted.
+        if(task->persistent)
+        {
+            if(task->continuation != nullptr)
+                post_internal(task->continuation);
+            return;
+        }
+
+        if(task->join != nullptr)
+        {
+            size_t remaining = task->join->decrement();
+            if(remaining == 0)
+            {
+                delete task->join;
+                task->join = nullptr;
+
+                if(task->continuation != nullptr)
+                {
+                    post_internal(task->continuation);
+                }
+            }
+        }
+        else
+        {
+            if(task->continuation != nullptr)
+            {
+                post_internal(task->continuation);
+            }
+        }
+
+        task->continuation = nullptr;
+        delete task;
+    }
+
+    /**
+    * Deletes a task which will never run. If it is the last of its join the
+    *  continuation goes with it, otherwise it is left to the other tasks of the join.
+    *  Persistent tasks are left to their owner, which their discard hook tells.
+    */
+    static void discard(task_t* task)
+    {
+        if(task->persistent)
+        {
+            // The hook may free the task, so it runs from a copy.
+            std::function<void()> hook = task->on_discard;
+            if(hook)
+                hook();
+            return;
+        }
+
+        if(task->on_discard)
+            task->on_discard();
+
+        if(task->join != nullptr)
+        {
+            if(task->join->decrement() == 0)
+            {
+                delete task->join;
+                delete task->continuation;
+            }
+            task->join = nullptr;
+            task->continuation = nullptr;
+        }
+        delete task;
+    }
+
+    Honeydew* set_exception_handler(std::function<void(std::exception_ptr)> handler, size_t worker=0, uint64_t priority=0)
+    {
+        exception_handler = handler;
+        exception_worker = worker;
+        exception_priority = priority;
+        return this;
+    }
+
+    /**
+    * Posts every timed task of the given wheel which is due.
+    * @arg next_tick output location for the tick of the wheel's next timed task.
+    * @return false if the wheel has no timed tasks left.
+    */
+    bool expire_timers(TimingWheel* wheel, uint64_t* next_tick)
+    {
+        if(wheel->size() == 0)
+            return false;
+
+        wheel->advance(current_tick(), [this] (TimingWheelNode* node) {
+            TimedTask* timed = static_cast<TimedTask*>(node);
+            post_internal(timed->task);
+            delete timed;
+        });
+
+        return wheel->next_tick(next_tick);
+    }
+
+    uint64_t current_tick() const
+    {
+        return std::chrono::duration_cast<timer_resolution>(std::chrono::steady_clock::now() - timer_start).count();
+    }
+
+    std::chrono::steady_clock::time_point time_of(uint64_t tick) const
+    {
+        return timer_start + timer_resolution(tick);
+    }
+
+    /**
+    * Returns the first tick at or after the given time, so a timed task never runs early.
+    */
+    uint64_t tick_of(std::chrono::steady_clock::time_point time) const
+    {
+        uint64_t expiry = 0;
+        if(time > timer_start)
+        {
+            std::chrono::steady_clock::duration offset = time - timer_start;
+            expiry = std::chrono::duration_cast<timer_resolution>(offset).count();
+            if(time_of(expiry) < time)
+                ++expiry;
+        }
+        return expiry;
+    }
+
+    std::function<void(std::exception_ptr)> exception_handler;
+    size_t exception_worker;
+    uint64_t exception_priority;
+
+    std::chrono::steady_clock::time_point timer_start;
+    Router* router;
+};
+
 typedef CountingWrapper<Queue<task_t>> CountingQueue;
 typedef CountingWrapper<BinaryMinHeap<task_t>> PriorityCountingQueue;
 
 template<typename QueueType>
-struct HoneydewImpl : public Honeydew
+struct HoneydewImpl : public WorkerGroupBase
 {
     typedef std::function<size_t(std::atomic_int_fast32_t&,task_t*,QueueType*,size_t)> FindQueueFunc;
 
-    HoneydewImpl(size_t num_threads, size_t step_size, FindQueueFunc findQueue)
-        : exception_handler(nullptr)
-        , exception_worker(0)
-        , exception_priority(0)
+    /**
+    * @arg router the Honeydew this is a group of, or nullptr if it stands alone.
+    * @arg first_worker the number of workers in the groups before this one.
+    * @arg total_workers the number of workers in all groups.
+    * @arg external whether the workers are left to application threads instead of having threads of their own.
+    */
+    HoneydewImpl(size_t num_threads, size_t step_size, size_t capacity, OverflowPolicy policy,
+                 Router* router, size_t first_worker, size_t total_workers, bool external, FindQueueFunc findQueue)
+        : WorkerGroupBase(router)
         , findQueue(findQueue)
         , num_threads(num_threads)
+        , step_size(step_size)
         , runningCount(0)
+        , capacity(capacity)
+        , policy(policy)
+        , first_worker(first_worker)
+        , total_workers(total_workers)
+        , external(external)
+        , running(new std::atomic<bool>[num_threads])
+        , blocking_pool([this] (task_t* task) { execute(task); })
     {
         queues = new QueueType[num_threads];
         for(size_t i=0; i < num_threads; ++i)
         {
-            threads.emplace_back(std::bind(&HoneydewImpl::run, this, &queues[i], step_size));
+            queues[i].set_capacity(capacity);
+            timers.push_back(new TimingWheel(0));
+            running[i] = false;
+        }
+        for(size_t i=0; !external && i < num_threads; ++i)
+        {
+            threads.emplace_back(std::bind(&HoneydewImpl::run, this, &queues[i]));
         }
     }
 
-    void run(QueueType* q, size_t step_size)
+    void run(QueueType* q)
     {
-        task_t *next;
+        current_honeydew = this;
+        current_index = q - queues;
+
+        TimingWheel* wheel = timers[current_index];
         while(1)
         {
-            task_t* task = nullptr;
-            q->pop(step_size, &task);
-            while(task != nullptr)
+            // Timed tasks are checked between batches. The wait for new work is cut short by the next one.
+            uint64_t next_tick;
+            if(expire_timers(wheel, &next_tick))
             {
-                try
-                {
-                    task->action();
-                }
-                catch(...)
-                {
-                    if(exception_handler != nullptr)
-                    {
-                        std::exception_ptr e = std::current_exception();
-                        post(new task_t([=]() {exception_handler(e);}, exception_worker, exception_priority));
-                    }
-                }
+                q->pop_until(step_size, &current_batch, time_of(next_tick));
+            }
+            else
+            {
+                q->pop(step_size, &current_batch);
+            }
 
-                if(task->join != nullptr)
-                {
-                    size_t prev_n = task->join->decrement();
-                    if(prev_n == 1)
-                    {
-                        delete task->join;
-                        task->join = nullptr;
-
-                        if(task->continuation != nullptr)
-                        {
-                            post(task->continuation);
-                        }
-                    }
-                }
-                else
-                {
-                    if(task->continuation != nullptr)
-                    {
-                        post(task->continuation);
-                    }
-                }
+            while(current_batch != nullptr)
+            {
+                task_t* task = current_batch;
+                current_batch = task->next;
+                task->next = nullptr;
+                execute(task);
+            }
 
+            std::this_thread::yield();
+        }
+    }
+
+
+
+    virtual Honeydew* post(task_t* task)
+    {
+        if(capacity == 0)
+        {
+            task_t* next;
+            while(task != nullptr)
+            {
                 next = task->next;
                 task->next = nullptr;
-                task->continuation = nullptr;
-                delete task;
+                if(task->blocking)
+                    blocking_pool.submit(task);
+                else
+                    queues[queue_index(task)].push(task);
                 task = next;
             }
+            return this;
+        }
 
-            std::this_thread::yield();
+        if(!post_bounded(task, policy == BLOCK) && policy == FAIL)
+            throw std::overflow_error("Honeydew queue is full.");
+        return this;
+    }
+
+    virtual bool try_post(task_t* task)
+    {
+        if(capacity == 0)
+        {
+            post(task);
+            return true;
         }
+
+        return post_bounded(task, false);
     }
 
-    virtual Honeydew* post(task_t* task)
+
+    virtual void post_local_internal(task_t* task)
+    {
+        if(capacity == 0)
+            post(task);
+        else
+            post_bounded(task, policy == BLOCK);
+    }
+
+    /**
+    * Posts each task of the list to a bounded queue, applying the overflow policy.
+    * @arg wait whether to wait for room (BLOCK) or reject the task when the queue is full.
+    * @return false if any task was rejected.
+    */
+    bool post_bounded(task_t* task, bool wait)
     {
+        bool all_posted = true;
         task_t* next;
         while(task != nullptr)
         {
             next = task->next;
             task->next = nullptr;
-            if(task->worker == 0)
+
+            // Blocking tasks don't take room in the workers' queues.
+            if(task->blocking)
             {
-                queues[findQueue(runningCount, task, queues, num_threads)].push(task);
+                blocking_pool.submit(task);
+                task = next;
+                continue;
             }
-            else
+
+            if(task->internal)
+            {
+                queues[queue_index(task)].push(task);
+                task = next;
+                continue;
+            }
+
+            QueueType& queue = queues[queue_index(task)];
+            if(policy == DROP_OLDEST || policy == DROP_LOWEST_PRIORITY)
+            {
+                task_t* evicted = queue.push_evicting(task, policy == DROP_LOWEST_PRIORITY);
+                if(evicted != nullptr)
+                    discard(evicted);
+            }
+            else if(wait && current_honeydew == this)
+            {
+                // A worker can't sleep on a full queue as it may be the one which has to empty it.
+                while(!queue.push_bounded(task, false))
+                {
+                    if(!help())
+                        std::this_thread::yield();
+                }
+            }
+            else if(!queue.push_bounded(task, wait))
             {
-                queues[task->worker % num_threads].push(task);
+                discard(task);
+                all_posted = false;
             }
             task = next;
         }
+        return all_posted;
+    }
+
+    virtual Honeydew* post_at(task_t* task, std::chrono::steady_clock::time_point time)
+    {
+        TimedTask* timed = new TimedTask(task, tick_of(time));
+
+        // A worker keeps the timer itself. Anyone else hands it to the worker the task would be posted to
+        //  with an internal task, which the overflow policy can't drop. The task itself is subject to
+        //  the policy once it is due.
+        if(current_honeydew == this)
+        {
+            timers[current_index]->insert(timed);
+        }
+        else
+        {
+            size_t index = queue_index(task);
+            TimingWheel* wheel = timers[index];
+            task_t* hand_over = new task_t([=] () { wheel->insert(timed); }, 0, 0);
+            hand_over->internal = true;
+            queues[index].push(hand_over);
+        }
         return this;
     }
 
-    Honeydew* set_exception_handler(std::function<void(std::exception_ptr)> handler, size_t worker=0, uint64_t priority=0) 
+
+    Honeydew* set_blocking_pool(size_t max_threads, std::chrono::milliseconds keep_alive)
     {
-        exception_handler = handler;
-        exception_worker = worker;
-        exception_priority = priority;
+        blocking_pool.set_limits(max_threads, keep_alive);
         return this;
     }
 
-    std::function<void(std::exception_ptr)> exception_handler;
-    size_t exception_worker;
-    uint64_t exception_priority;
- 
+    size_t num_workers() const
+    {
+        return num_threads;
+    }
+
+    size_t current_worker() const
+    {
+        return current_honeydew == this ? current_index : no_worker;
+    }
+
+    size_t current_worker_id() const
+    {
+        if(current_honeydew != this)
+            return 0;
+        // Worker ids count from 1 and wrap around, so the group's first queue is targeted by its last id.
+        return first_worker + (current_index == 0 ? num_threads : current_index);
+    }
+
+    size_t run_worker(size_t worker, size_t max_tasks, std::chrono::steady_clock::time_point deadline)
+    {
+        size_t index = external_index(worker);
+        WorkerScope scope(this, index, running[index]);
+
+        QueueType& q = queues[index];
+        TimingWheel* wheel = timers[index];
+        size_t ran = 0;
+        while(max_tasks == 0 || ran < max_tasks)
+        {
+            if(current_batch == nullptr)
+            {
+                // Never take more tasks than are left to run.
+                size_t step = step_size;
+                if(max_tasks != 0 && (step == 0 || step > max_tasks - ran))
+                    step = max_tasks - ran;
+
+                uint64_t next_tick;
+                bool has_timers = expire_timers(wheel, &next_tick);
+                q.try_pop(step, &current_batch);
+                if(current_batch == nullptr)
+                {
+                    if(deadline <= std::chrono::steady_clock::now())
+                        break;
+
+                    if(has_timers && time_of(next_tick) < deadline)
+                        q.pop_until(step, &current_batch, time_of(next_tick));
+                    else if(deadline == std::chrono::steady_clock::time_point::max())
+                        q.pop(step, &current_batch);
+                    else
+                        q.pop_until(step, &current_batch, deadline);
+                    continue;
+                }
+            }
+
+            task_t* task = current_batch;
+            current_batch = task->next;
+            task->next = nullptr;
+            execute(task);
+            ++ran;
+        }
+
+        // A task which helped may have left part of a batch behind.
+        while(current_batch != nullptr)
+        {
+            task_t* task = current_batch;
+            current_batch = task->next;
+            task->next = nullptr;
+            q.push(task);
+        }
+        return ran;
+    }
+
+    /**
+    * Returns the index of a worker which application threads may run. Throws otherwise.
+    */
+    size_t external_index(size_t worker) const
+    {
+        if(worker == 0 || (worker & group_bit) != 0)
+            throw std::out_of_range("run_worker needs the id of a single worker.");
+        if(!external)
+            throw std::logic_error("Honeydew worker " + std::to_string(worker) + " runs on a thread of its own.");
+        return ((worker - 1) % total_workers + 1 - first_worker) % num_threads;
+    }
+
+    size_t group(const std::string& name) const
+    {
+        throw std::out_of_range("Honeydew has no worker group named " + name);
+    }
+
+    /**
+    * Returns the queue a task goes to. Workers are numbered across all groups; a task for a
+    *  specific worker of this group goes to that worker's queue, anything else is placed by findQueue.
+    */
+    size_t queue_index(task_t* task)
+    {
+        if(task->worker == 0 || (task->worker & group_bit) != 0)
+            return findQueue(runningCount, task, queues, num_threads);
+        return ((task->worker - 1) % total_workers + 1 - first_worker) % num_threads;
+    }
+
+    bool help()
+    {
+        if(current_honeydew != this)
+            return false;
+
+        if(current_batch == nullptr)
+        {
+            uint64_t next_tick;
+            expire_timers(timers[current_index], &next_tick);
+
+            queues[current_index].try_pop(step_size, &current_batch);
+            if(current_batch == nullptr)
+                return false;
+        }
+
+        task_t* task = current_batch;
+        current_batch = task->next;
+        task->next = nullptr;
+        execute(task);
+        return true;
+    }
+
     std::vector<std::thread> threads;
     FindQueueFunc findQueue;
     QueueType* queues;
     size_t num_threads;
+    size_t step_size;
     std::atomic_int_fast32_t runningCount;
+    size_t capacity;
+    OverflowPolicy policy;
+
+    std::vector<TimingWheel*> timers;
+
+    size_t first_worker;
+    size_t total_workers;
+
+    bool external;
+    std::unique_ptr<std::atomic<bool>[]> running;
+
+    BlockingPool blocking_pool;
 };
 
 /**
-* Creates a new Honeydew of the given type.
-* @param type the type of the Honeydew to create. This cooresponds to how resource-less events are scheduled.
-* @param num_threads the number of workers to create. This affects the number of independent work queues.
-*                       if the number of resources > num_threads some resources will share a thread.
-* @param step_size the maximum number of events each worker removes from the queue at a time. 0 is infinite.
+* A thread-per-core set of workers which share nothing on the hot path. Each worker owns its
+*  run queue and timers outright. A task for another worker travels through a single producer
+*  single consumer ring reserved for that pair of workers, and threads which are not workers
+*  hand tasks over through each worker's injection ring, so posting never takes a lock.
+*  A worker drains its rings between batches and only sleeps, on its own condition variable,
+*  once all of them are empty.
+*/
+struct ThreadPerCoreHoneydew : public WorkerGroupBase
+{
+    static const size_t default_ring_size = 1024;
+    static const size_t idle_spins = 64;
+
+    /**
+    * The state of one worker. Everything above the rings is only touched by the worker's own thread.
+    */
+    struct Worker
+    {
+        Worker(size_t num_threads, size_t ring_size)
+            : local_head(nullptr)
+            , local_tail(nullptr)
+            , backlog_head(num_threads, nullptr)
+            , backlog_tail(num_threads, nullptr)
+            , backlogged(0)
+            , wheel(0)
+            , injection(ring_size)
+            , sleeping(false)
+            , woken(false)
+            , running(false)
+        {
+            for(size_t i=0; i < num_threads; ++i)
+            {
+                inbound.push_back(new SpscRing<task_t>(ring_size));
+            }
+        }
+
+        ~Worker()
+        {
+            for(size_t i=0; i < inbound.size(); ++i)
+            {
+                delete inbound[i];
+            }
+        }
+
+        void push_local(task_t* task)
+        {
+            if(local_tail == nullptr)
+                local_head = task;
+            else
+                local_tail->next = task;
+            local_tail = task;
+        }
+
+        task_t* pop_local()
+        {
+            task_t* task = local_head;
+            if(task != nullptr)
+            {
+                local_head = task->next;
+                if(local_head == nullptr)
+                    local_tail = nullptr;
+                task->next = nullptr;
+            }
+            return task;
+        }
+
+        // Tasks ready to run, in the order they arrived.
+        task_t* local_head;
+        task_t* local_tail;
+
+        // Tasks for other workers which didn't fit in their rings, kept in order until there is room.
+        std::vector<task_t*> backlog_head;
+        std::vector<task_t*> backlog_tail;
+        size_t backlogged;
+
+        TimingWheel wheel;
+
+        // inbound[i] is written by worker i only. The worker's own entry is unused.
+        std::vector<SpscRing<task_t>*> inbound;
+        MpscRing<task_t> injection;
+
+        std::atomic<bool> sleeping;
+        std::mutex m;
+        std::condition_variable cv;
+        bool woken;
+
+        // Set while an application thread runs this worker.
+        std::atomic<bool> running;
+    };
+
+    /**
+    * @arg capacity the number of slots of each ring. 0 uses default_ring_size.
+    * @arg router the Honeydew this is a group of, or nullptr if it stands alone.
+    * @arg first_worker the number of workers in the groups before this one.
+    * @arg total_workers the number of workers in all groups.
+    * @arg external whether the workers are left to application threads instead of having threads of their own.
+    */
+    ThreadPerCoreHoneydew(size_t num_threads, size_t step_size, size_t capacity, OverflowPolicy policy,
+                          Router* router, size_t first_worker, size_t total_workers, bool external)
+        : WorkerGroupBase(router)
+        , num_threads(num_threads)
+        , step_size(step_size)
+        , policy(policy)
+        , next_injection(0)
+        , first_worker(first_worker)
+        , total_workers(total_workers)
+        , external(external)
+        , blocking_pool([this] (task_t* task) { execute(task); })
+    {
+        for(size_t i=0; i < num_threads; ++i)
+        {
+            workers.push_back(new Worker(num_threads, capacity == 0 ? default_ring_size : capacity));
+        }
+        for(size_t i=0; !external && i < num_threads; ++i)
+        {
+            threads.emplace_back(std::bind(&ThreadPerCoreHoneydew::run, this, i));
+        }
+    }
+
+    void run(size_t index)
+    {
+        current_honeydew = this;
+        current_index = index;
+
+        Worker& w = *workers[index];
+        while(1)
+        {
+            poll(w);
+
+            uint64_t next_tick;
+            bool has_timers = expire_timers(&w.wheel, &next_tick);
+
+            size_t ran = 0;
+            task_t* task;
+            while((step_size == 0 || ran < step_size) && (task = w.pop_local()) != nullptr)
+            {
+                execute(task);
+                ++ran;
+            }
+
+            if(ran == 0)
+                idle(w, has_timers, next_tick, std::chrono::steady_clock::time_point::max());
+        }
+    }
+
+    /**
+    * Moves the tasks waiting in the worker's rings to its run queue and retries its backlog.
+    */
+    void poll(Worker& w)
+    {
+        task_t* task;
+        for(size_t i=0; i < num_threads; ++i)
+        {
+            while((task = w.inbound[i]->try_pop()) != nullptr)
+            {
+                w.push_local(task);
+            }
+        }
+        while((task = w.injection.try_pop()) != nullptr)
+        {
+            w.push_local(task);
+        }
+
+        if(w.backlogged != 0)
+            flush_backlog(w);
+    }
+
+    void flush_backlog(Worker& w)
+    {
+        for(size_t to=0; to < num_threads; ++to)
+        {
+            task_t* task = w.backlog_head[to];
+            if(task == nullptr)
+                continue;
+
+            SpscRing<task_t>& ring = *workers[to]->inbound[current_index];
+            bool sent = false;
+            while(task != nullptr)
+            {
+                task_t* next = task->next;
+                task->next = nullptr;
+                if(!ring.try_push(task))
+                {
+                    task->next = next;
+                    break;
+                }
+                sent = true;
+                task = next;
+            }
+
+            w.backlog_head[to] = task;
+            if(task == nullptr)
+            {
+                w.backlog_tail[to] = nullptr;
+                --w.backlogged;
+            }
+            if(sent)
+                wake(*workers[to]);
+        }
+    }
+
+    bool has_input(Worker& w)
+    {
+        for(size_t i=0; i < num_threads; ++i)
+        {
+            if(!w.inbound[i]->empty())
+                return true;
+        }
+        return !w.injection.empty();
+    }
+
+    /**
+    * Waits for a task to arrive, the next timer to be due or the deadline to pass. A worker with
+    *  a backlog only yields as nobody tells it when another worker makes room.
+    */
+    void idle(Worker& w, bool has_timers, uint64_t next_tick, std::chrono::steady_clock::time_point deadline)
+    {
+        if(w.backlogged != 0)
+        {
+            std::this_thread::yield();
+            return;
+        }
+
+        // Most tasks are answered quickly, so poll a little before paying for a sleep and a wake up.
+        for(size_t i=0; i < idle_spins; ++i)
+        {
+            if(has_input(w))
+                return;
+            std::this_thread::yield();
+        }
+
+        // Pairs with the fence in wake: either the poster sees sleeping or we see its task.
+        w.sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(!has_input(w))
+        {
+            if(has_timers && time_of(next_tick) < deadline)
+                deadline = time_of(next_tick);
+
+            std::unique_lock<std::mutex> lg(w.m);
+            if(deadline != std::chrono::steady_clock::time_point::max())
+                w.cv.wait_until(lg, deadline, [&w] () { return w.woken; });
+            else
+                w.cv.wait(lg, [&w] () { return w.woken; });
+            w.woken = false;
+        }
+        w.sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    void wake(Worker& w)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(w.sleeping.load(std::memory_order_relaxed))
+        {
+            std::unique_lock<std::mutex> lg(w.m);
+            w.woken = true;
+            w.cv.notify_one();
+        }
+    }
+
+    /**
+    * Returns the worker a task goes to. Worker 0 stays on the posting worker, and tasks from
+    *  other threads are spread over the workers in turn.
+    */
+    size_t worker_index(task_t* task)
+    {
+        if(task->worker == 0 || (task->worker & group_bit) != 0)
+        {
+            if(current_honeydew == this)
+                return current_index;
+            return next_injection.fetch_add(1, std::memory_order_relaxed) % num_threads;
+        }
+        return ((task->worker - 1) % total_workers + 1 - first_worker) % num_threads;
+    }
+
+    /**
+    * Hands a single task to the worker it targets.
+    * @arg wait whether a thread which is not a worker waits for room in a full injection ring.
+    *  Internal tasks always wait.
+    * @return false if the task was rejected, in which case it has been discarded.
+    */
+    bool route(task_t* task, bool wait)
+    {
+        if(task->blocking)
+        {
+            blocking_pool.submit(task);
+            return true;
+        }
+
+        size_t to = worker_index(task);
+        if(current_honeydew == this)
+        {
+            // A worker never waits: what doesn't fit in a ring waits in its own backlog.
+            Worker& w = *workers[current_index];
+            if(to == current_index)
+            {
+                w.push_local(task);
+            }
+            else if(w.backlog_head[to] == nullptr && workers[to]->inbound[current_index]->try_push(task))
+            {
+                wake(*workers[to]);
+            }
+            else
+            {
+                if(w.backlog_head[to] == nullptr)
+                {
+                    w.backlog_head[to] = task;
+                    ++w.backlogged;
+                }
+                else
+                {
+                    w.backlog_tail[to]->next = task;
+                }
+                w.backlog_tail[to] = task;
+            }
+            return true;
+        }
+
+        Worker& w = *workers[to];
+        while(!w.injection.try_push(task))
+        {
+            if(!wait && !task->internal)
+            {
+                discard(task);
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        wake(w);
+        return true;
+    }
+
+    bool route_all(task_t* task, bool wait)
+    {
+        bool all_posted = true;
+        task_t* next;
+        while(task != nullptr)
+        {
+            next = task->next;
+            task->next = nullptr;
+            all_posted = route(task, wait) && all_posted;
+            task = next;
+        }
+        return all_posted;
+    }
+
+    virtual Honeydew* post(task_t* task)
+    {
+        if(!route_all(task, policy != FAIL) && policy == FAIL)
+            throw std::overflow_error("Honeydew injection ring is full.");
+        return this;
+    }
+
+    virtual bool try_post(task_t* task)
+    {
+        return route_all(task, false);
+    }
+
+    virtual void post_local_internal(task_t* task)
+    {
+        route_all(task, true);
+    }
+
+    virtual Honeydew* post_at(task_t* task, std::chrono::steady_clock::time_point time)
+    {
+        TimedTask* timed = new TimedTask(task, tick_of(time));
+
+        // Only its owner touches a wheel, so anyone else sends the timer to the worker the task would be posted to.
+        if(current_honeydew == this)
+        {
+            workers[current_index]->wheel.insert(timed);
+        }
+        else
+        {
+            size_t to = worker_index(task);
+            TimingWheel* wheel = &workers[to]->wheel;
+            task_t* hand_over = new task_t([=] () { wheel->insert(timed); }, id_of(to), 0);
+            hand_over->internal = true;
+            route(hand_over, true);
+        }
+        return this;
+    }
+
+    Honeydew* set_blocking_pool(size_t max_threads, std::chrono::milliseconds keep_alive)
+    {
+        blocking_pool.set_limits(max_threads, keep_alive);
+        return this;
+    }
+
+    size_t num_workers() const
+    {
+        return num_threads;
+    }
+
+    size_t current_worker() const
+    {
+        return current_honeydew == this ? current_index : no_worker;
+    }
+
+    size_t current_worker_id() const
+    {
+        return current_honeydew == this ? id_of(current_index) : 0;
+    }
+
+    /**
+    * Returns the worker id which targets the given worker. Ids count from 1 and wrap around.
+    */
+    size_t id_of(size_t index) const
+    {
+        return first_worker + (index == 0 ? num_threads : index);
+    }
+
+    size_t run_worker(size_t worker, size_t max_tasks, std::chrono::steady_clock::time_point deadline)
+    {
+        if(worker == 0 || (worker & group_bit) != 0)
+            throw std::out_of_range("run_worker needs the id of a single worker.");
+        if(!external)
+            throw std::logic_error("Honeydew worker " + std::to_string(worker) + " runs on a thread of its own.");
+
+        size_t index = ((worker - 1) % total_workers + 1 - first_worker) % num_threads;
+        WorkerScope scope(this, index, workers[index]->running);
+
+        Worker& w = *workers[index];
+        size_t ran = 0;
+        while(max_tasks == 0 || ran < max_tasks)
+        {
+            task_t* task = w.pop_local();
+            if(task == nullptr)
+            {
+                poll(w);
+                uint64_t next_tick;
+                bool has_timers = expire_timers(&w.wheel, &next_tick);
+                task = w.pop_local();
+                if(task == nullptr)
+                {
+                    if(deadline <= std::chrono::steady_clock::now())
+                        break;
+                    idle(w, has_timers, next_tick, deadline);
+                    continue;
+                }
+            }
+
+            execute(task);
+            ++ran;
+        }
+
+        // Nobody else may send from this worker's rings, so send what waits in its backlog now.
+        if(w.backlogged != 0)
+            flush_backlog(w);
+        return ran;
+    }
+
+    size_t group(const std::string& name) const
+    {
+        throw std::out_of_range("Honeydew has no worker group named " + name);
+    }
+
+    bool help()
+    {
+        if(current_honeydew != this)
+            return false;
+
+        Worker& w = *workers[current_index];
+        task_t* task = w.pop_local();
+        if(task == nullptr)
+        {
+            poll(w);
+            uint64_t next_tick;
+            expire_timers(&w.wheel, &next_tick);
+            task = w.pop_local();
+            if(task == nullptr)
+                return false;
+        }
+
+        execute(task);
+        return true;
+    }
+
+    std::vector<std::thread> threads;
+    std::vector<Worker*> workers;
+    size_t num_threads;
+    size_t step_size;
+    OverflowPolicy policy;
+    std::atomic<size_t> next_injection;
+
+    size_t first_worker;
+    size_t total_workers;
+    bool external;
+
+    BlockingPool blocking_pool;
+};
+
+const size_t ThreadPerCoreHoneydew::default_ring_size;
+
+static WorkerGroupBase* create_group(Honeydew::HoneydewType type, size_t num_threads, size_t step_size, size_t capacity,
+                                     Honeydew::OverflowPolicy policy, Router* router, size_t first_worker, size_t total_workers, bool external);
+
+/**
+* A Honeydew made of several worker groups. Each task goes to the group owning the worker it
+*  targets, which then places it with its own policy.
+*/
+struct GroupedHoneydew : public Honeydew, public Router
+{
+    GroupedHoneydew(const std::vector<WorkerGroup>& descriptions)
+        : total(0)
+    {
+        if(descriptions.empty())
+            throw std::runtime_error("A Honeydew needs at least one worker group.");
+
+        for(size_t g=0; g < descriptions.size(); ++g)
+        {
+            for(size_t i=0; i < g; ++i)
+            {
+                if(descriptions[i].name == descriptions[g].name)
+                    throw std::runtime_error("Duplicate worker group " + descriptions[g].name);
+            }
+            total += descriptions[g].num_threads;
+        }
+
+        size_t first = 0;
+        for(size_t g=0; g < descriptions.size(); ++g)
+        {
+            const WorkerGroup& d = descriptions[g];
+            names.push_back(d.name);
+            first_workers.push_back(first);
+            groups.push_back(create_group(d.type, d.num_threads, d.step_size, d.capacity, d.policy, this, first, total, d.external));
+            first += d.num_threads;
+        }
+    }
+
+    /**
+    * Returns the index of the group owning the worker the task targets.
+    */
+    size_t group_of(const task_t* task) const
+    {
+        return group_of(task->worker);
+    }
+
+    size_t group_of(size_t worker) const
+    {
+        if(worker == 0)
+            return 0;
+        if((worker & group_bit) != 0)
+            return (worker & ~group_bit) % groups.size();
+
+        worker = (worker - 1) % total;
+        size_t g = groups.size() - 1;
+        while(first_workers[g] > worker)
+            --g;
+        return g;
+    }
+
+    virtual Honeydew* post(task_t* task)
+    {
+        // A full group under the FAIL policy throws. The rest of the list is still posted.
+        std::exception_ptr error = nullptr;
+        task_t* next;
+        while(task != nullptr)
+        {
+            next = task->next;
+            task->next = nullptr;
+            try
+            {
+                groups[group_of(task)]->post(task);
+            }
+            catch(...)
+            {
+                if(error == nullptr)
+                    error = std::current_exception();
+            }
+            task = next;
+        }
+
+        if(error != nullptr)
+            std::rethrow_exception(error);
+        return this;
+    }
+
+    virtual bool try_post(task_t* task)
+    {
+        bool all_posted = true;
+        task_t* next;
+        while(task != nullptr)
+        {
+            next = task->next;
+            task->next = nullptr;
+            all_posted = groups[group_of(task)]->try_post(task) && all_posted;
+            task = next;
+        }
+        return all_posted;
+    }
+
+    virtual void post_internal(task_t* task)
+    {
+        task_t* next;
+        while(task != nullptr)
+        {
+            next = task->next;
+            task->next = nullptr;
+            groups[group_of(task)]->post_local_internal(task);
+            task = next;
+        }
+    }
+
+    virtual Honeydew* post_at(task_t* task, std::chrono::steady_clock::time_point time)
+    {
+        groups[group_of(task)]->post_at(task, time);
+        return this;
+    }
+
+    Honeydew* set_exception_handler(std::function<void(std::exception_ptr)> handler, size_t worker=0, uint64_t priority=0)
+    {
+        for(size_t g=0; g < groups.size(); ++g)
+        {
+            groups[g]->set_exception_handler(handler, worker, priority);
+        }
+        return this;
+    }
+
+    Honeydew* set_blocking_pool(size_t max_threads, std::chrono::milliseconds keep_alive)
+    {
+        for(size_t g=0; g < groups.size(); ++g)
+        {
+            groups[g]->set_blocking_pool(max_threads, keep_alive);
+        }
+        return this;
+    }
+
+    size_t num_workers() const
+    {
+        return total;
+    }
+
+    size_t current_worker() const
+    {
+        for(size_t g=0; g < groups.size(); ++g)
+        {
+            size_t worker = groups[g]->current_worker();
+            if(worker != no_worker)
+                return first_workers[g] + worker;
+        }
+        return no_worker;
+    }
+
+    size_t current_worker_id() const
+    {
+        for(size_t g=0; g < groups.size(); ++g)
+        {
+            size_t id = groups[g]->current_worker_id();
+            if(id != 0)
+                return id;
+        }
+        return 0;
+    }
+
+    size_t run_worker(size_t worker, size_t max_tasks, std::chrono::steady_clock::time_point deadline)
+    {
+        if(worker == 0 || (worker & group_bit) != 0)
+            throw std::out_of_range("run_worker needs the id of a single worker.");
+        return groups[group_of(worker)]->run_worker(worker, max_tasks, deadline);
+    }
+
+    size_t group(const std::string& name) const
+    {
+        for(size_t g=0; g < names.size(); ++g)
+        {
+            if(names[g] == name)
+                return group_bit | g;
+        }
+        throw std::out_of_range("Honeydew has no worker group named " + name);
+    }
+
+    bool help()
+    {
+        for(size_t g=0; g < groups.size(); ++g)
+        {
+            if(groups[g]->current_worker() != no_worker)
+                return groups[g]->help();
+        }
+        return false;
+    }
+
+    std::vector<WorkerGroupBase*> groups;
+    std::vector<std::string> names;
+    std::vector<size_t> first_workers;
+    size_t total;
+};
+
+/**
+* Creates a new Honeydew of the given type.
+* @param type the type of the Honeydew to create. This cooresponds to how resource-less events are scheduled.
+* @param num_threads the number of workers to create. This affects the number of independent work queues.
+*                       if the number of resources > num_threads some resources will share a thread.
+* @param step_size the maximum number of events each worker removes from the queue at a time. 0 is infinite.
+* @param capacity the maximum number of tasks queued per worker. 0 is unbounded.
+* @param policy what to do when a task is posted to a full queue.
+*/
+Honeydew* Honeydew::create(HoneydewType type, size_t num_threads, size_t step_size, size_t capacity, OverflowPolicy policy)
+{
+    return create_group(type, num_threads, step_size, capacity, policy, nullptr, 0, num_threads, false);
+}
+
+/**
+* Creates a new Honeydew made of the given worker groups.
+* @param groups the groups to create. Names must be unique.
+*/
+Honeydew* Honeydew::create(const std::vector<WorkerGroup>& groups)
+{
+    return new GroupedHoneydew(groups);
+}
+
+/**
+* Creates a set of workers of the given type, standing alone or as one group of a GroupedHoneydew.
 */
-Honeydew* Honeydew::create(HoneydewType type, size_t num_threads, size_t step_size)
+static WorkerGroupBase* create_group(Honeydew::HoneydewType type, size_t num_threads, size_t step_size, size_t capacity,
+                                     Honeydew::OverflowPolicy policy, Router* router, size_t first_worker, size_t total_workers, bool external)
 {
     switch(type)
     {
-    case ROUND_ROBIN:
-        return new HoneydewImpl<Queue<task_t>>(num_threads, step_size,
+    case Honeydew::ROUND_ROBIN:
+        return new HoneydewImpl<Queue<task_t>>(num_threads, step_size, capacity, policy, router, first_worker, total_workers, external,
         [] (std::atomic_int_fast32_t& running_count, task_t* task, Queue<task_t>* queues, size_t num_queues) {
             return running_count.fetch_add(1) % num_queues;
         });
-    case ROUND_ROBIN_WITH_PRIORITY:
-        return new HoneydewImpl<BinaryMinHeap<task_t>>(num_threads, step_size,
+    case Honeydew::ROUND_ROBIN_WITH_PRIORITY:
+        return new HoneydewImpl<BinaryMinHeap<task_t>>(num_threads, step_size, capacity, policy, router, first_worker, total_workers, external,
         [] (std::atomic_int_fast32_t& running_count, task_t* task, BinaryMinHeap<task_t>* queues, size_t num_queues) {
             return running_count.fetch_add(1) % num_queues;
         });
-    case LEAST_BUSY:
-        return new HoneydewImpl<CountingQueue>(num_threads, step_size,
+    case Honeydew::LEAST_BUSY:
+        return new HoneydewImpl<CountingQueue>(num_threads, step_size, capacity, policy, router, first_worker, total_workers, external,
         [] (std::atomic_int_fast32_t& running_count, task_t* task, CountingQueue* queues, size_t num_queues) {
             size_t least_busy = 0;
             size_t least_busy_amt = queues[0].size();
@@ -166,8 +1369,8 @@ Honeydew* Honeydew::create(HoneydewType type, size_t num_threads, size_t step_si
             }
             return least_busy;
         });
-    case LEAST_BUSY_WITH_PRIORITY:
-        return new HoneydewImpl<PriorityCountingQueue>(num_threads, step_size,
+    case Honeydew::LEAST_BUSY_WITH_PRIORITY:
+        return new HoneydewImpl<PriorityCountingQueue>(num_threads, step_size, capacity, policy, router, first_worker, total_workers, external,
         [] (std::atomic_int_fast32_t& running_count, task_t* task, PriorityCountingQueue* queues, size_t num_queues) {
             size_t least_busy = 0;
             size_t least_busy_amt = queues[0].size();
@@ -182,6 +1385,8 @@ Honeydew* Honeydew::create(HoneydewType type, size_t num_threads, size_t step_si
             }
             return least_busy;
         });
+    case Honeydew::THREAD_PER_CORE:
+        return new ThreadPerCoreHoneydew(num_threads, step_size, capacity, policy, router, first_worker, total_workers, external);
     }
     return nullptr;
 }
@@ -12,6 +12,11 @@ task_t::task_t(std::function<void()> action, size_t worker, uint64_t deadline)
     , continuation(nullptr)
     , join(nullptr)
     , worker(worker)
+    , persistent(false)
+    , blocking(false)
+    , internal(false)
+    , fusable(true)
+    , on_discard(nullptr)
     , next(nullptr)
 {
 }